@@ -15,31 +15,45 @@ SOURCES += lib/7zSDK/C/Alloc.c \
            lib/7zSDK/CPP/Common/MyString.cpp \
            lib/7zSDK/CPP/Common/MyVector.cpp \
            src/bit7zlibrary.cpp \
+           src/bitarchivecache.cpp \
+           src/bitarchivecatalog.cpp \
            src/bitarchivecreator.cpp \
            src/bitarchivehandler.cpp \
            src/bitarchiveinfo.cpp \
            src/bitarchiveitem.cpp \
            src/bitarchiveopener.cpp \
+           src/bitarchivereader.cpp \
+           src/bitchunkedbuffer.cpp \
            src/bitcompressor.cpp \
            src/bitexception.cpp \
            src/bitextractor.cpp \
            src/bitformat.cpp \
            src/bitguids.cpp \
+           src/bititemsbuffer.cpp \
            src/bitmemcompressor.cpp \
            src/bitmemextractor.cpp \
+           src/bitpathindex.cpp \
            src/bitpropvariant.cpp \
            src/callback.cpp \
+           src/cbufferedinstream.cpp \
+           src/cmappedinstream.cpp \
+           src/coutchunkedstream.cpp \
            src/coutmemstream.cpp \
            src/coutmultivolstream.cpp \
+           src/coutsinkstream.cpp \
+           src/crangeinstream.cpp \
            src/extractcallback.cpp \
+           src/fileprefetcher.cpp \
            src/fsindexer.cpp \
            src/fsitem.cpp \
            src/fsutil.cpp \
            src/memextractcallback.cpp \
            src/memupdatecallback.cpp \
            src/opencallback.cpp \
+           src/sinkextractcallback.cpp \
            src/updatecallback.cpp \
-           src/util.cpp
+           src/util.cpp \
+           src/zipmerger.cpp
 
 INCLUDEPATH += lib/7zSDK/CPP/
 
@@ -50,33 +64,48 @@ DEFINES += _UNICODE _7Z_VOL
 
 HEADERS += include/bit7z.hpp \
            include/bit7zlibrary.hpp \
+           include/bitarchivecache.hpp \
+           include/bitarchivecatalog.hpp \
            include/bitarchivecreator.hpp \
            include/bitarchivehandler.hpp \
            include/bitarchiveinfo.hpp \
            include/bitarchiveitem.hpp \
            include/bitarchiveopener.hpp \
+           include/bitarchivereader.hpp \
+           include/bitchunkedbuffer.hpp \
            include/bitcompressionlevel.hpp \
+           include/bitcompressionmethod.hpp \
            include/bitcompressor.hpp \
            include/bitexception.hpp \
            include/bitextractor.hpp \
            include/bitformat.hpp \
            include/bitguids.hpp \
+           include/bititemsbuffer.hpp \
            include/bitmemcompressor.hpp \
            include/bitmemextractor.hpp \
+           include/bitpathindex.hpp \
            include/bitpropvariant.hpp \
            include/bittypes.hpp \
            include/callback.hpp \
+           include/cbufferedinstream.hpp \
+           include/cmappedinstream.hpp \
+           include/coutchunkedstream.hpp \
            include/coutmemstream.hpp \
            include/coutmultivolstream.hpp \
+           include/coutsinkstream.hpp \
+           include/crangeinstream.hpp \
            include/extractcallback.hpp \
+           include/fileprefetcher.hpp \
            include/fsindexer.hpp \
            include/fsitem.hpp \
            include/fsutil.hpp \
            include/memextractcallback.hpp \
            include/memupdatecallback.hpp \
            include/opencallback.hpp \
+           include/sinkextractcallback.hpp \
            include/updatecallback.hpp \
-           include/util.hpp
+           include/util.hpp \
+           include/zipmerger.hpp
 
 contains(QT_ARCH, i386) {
     QMAKE_LFLAGS         += /MACHINE:X86
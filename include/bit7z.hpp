@@ -19,11 +19,17 @@
 #ifndef BIT7Z_HPP
 #define BIT7Z_HPP
 
+#include "bitarchivecache.hpp"
+#include "bitarchivecatalog.hpp"
 #include "bitarchiveinfo.hpp"
+#include "bitarchivereader.hpp"
+#include "bitchunkedbuffer.hpp"
 #include "bitcompressor.hpp"
 #include "bitmemcompressor.hpp"
 #include "bitextractor.hpp"
+#include "bititemsbuffer.hpp"
 #include "bitmemextractor.hpp"
+#include "bitpathindex.hpp"
 #include "bitexception.hpp"
 
 #endif // BIT7Z_HPP
@@ -0,0 +1,121 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITARCHIVECACHE_HPP
+#define BITARCHIVECACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../include/bit7zlibrary.hpp"
+#include "../include/bitarchivereader.hpp"
+#include "../include/bitformat.hpp"
+
+namespace bit7z {
+    using std::wstring;
+    using std::shared_ptr;
+
+    /**
+     * @brief The BitArchiveCacheStats struct contains the counters of a BitArchiveCache.
+     */
+    struct BitArchiveCacheStats {
+        uint64_t hits;          ///< The number of requests served by an already opened archive.
+        uint64_t misses;        ///< The number of requests that needed to open the archive.
+        uint64_t evictions;     ///< The number of opened archives discarded by the cache (e.g. when full or stale).
+        uint32_t handlesCount;  ///< The number of opened archives currently held by the cache.
+        uint64_t memoryUsage;   ///< The (estimated) memory used by the opened archives currently held by the cache.
+    };
+
+    /**
+     * @brief The BitArchiveCache class keeps a pool of opened archives (i.e. BitArchiveReader objects), so that
+     * archives requested repeatedly are opened (and parsed) only once.
+     *
+     * Archives are identified by their file (i.e. its volume and its index in the volume, so that different paths of
+     * the same file share the same entries), size, last modification time, format and password: hence, a modified
+     * archive file is always reopened, and stale entries are discarded.
+     *
+     * When the number of cached archives or their estimated memory usage exceed the given limits, the least recently
+     * used archives are closed.
+     *
+     * @note The limits apply only to the archives held by the cache: the readers currently leased (see open) are not
+     * counted, hence the total number of opened archives may exceed the limits by the number of leased readers.
+     *
+     * @note All the methods of this class are thread-safe. Since BitArchiveReader objects are not, each reader is
+     * leased to only one user at a time: it is removed from the cache by the open method and it is put back into it
+     * (as the most recently used one) when the last copy of the returned shared pointer is destroyed. Hence, many
+     * threads requesting the same archive at the same time will obtain different readers.
+     */
+    class BitArchiveCache {
+        public:
+            /**
+             * @brief Constructs a BitArchiveCache object.
+             *
+             * @param lib           the 7z library used.
+             * @param max_handles   the maximum number of opened archives kept by the cache.
+             * @param max_memory    the maximum (estimated) memory, in bytes, used by the opened archives kept by the
+             *                      cache (0 means no limit).
+             */
+            explicit BitArchiveCache( const Bit7zLibrary& lib, uint32_t max_handles = 64, uint64_t max_memory = 0 );
+
+            /**
+             * @brief BitArchiveCache destructor.
+             *
+             * @note Readers still leased when the cache is destroyed remain valid, and they are closed when released.
+             */
+            virtual ~BitArchiveCache();
+
+            /**
+             * @brief Returns a reader of the given archive, opening it only if no cached reader is available.
+             *
+             * @note The reader is given back to the cache when the last copy of the returned pointer is destroyed;
+             * the callbacks and the options (e.g. the decoder threads count and the free space check) set to the reader
+             * in the meantime are reset to their defaults, and its password is restored.
+             *
+             * @param in_file   the input archive file path.
+             * @param format    the input archive format.
+             * @param password  (optional) the password needed to open the archive.
+             *
+             * @return a shared pointer to the reader of the archive.
+             */
+            shared_ptr< BitArchiveReader > open( const wstring& in_file, const BitInFormat& format,
+                                                 const wstring& password = L"" );
+
+            /**
+             * @brief Closes all the opened archives held by the cache.
+             */
+            void clear();
+
+            /**
+             * @return the current counters of the cache.
+             */
+            BitArchiveCacheStats stats() const;
+
+        private:
+            struct State;
+
+            const Bit7zLibrary& mLibrary;
+            shared_ptr< State > mState;
+
+            //non-copyable
+            BitArchiveCache( const BitArchiveCache& other );
+            BitArchiveCache& operator=( const BitArchiveCache& other );
+    };
+}
+
+#endif // BITARCHIVECACHE_HPP
@@ -0,0 +1,162 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITARCHIVECATALOG_HPP
+#define BITARCHIVECATALOG_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../include/bitarchiveitem.hpp"
+#include "../include/bitpropvariant.hpp"
+
+struct IInArchive;
+
+namespace bit7z {
+    using std::wstring;
+    using std::vector;
+    using std::map;
+
+    class BitArchiveInfo;
+
+    /**
+     * @brief The BitArchiveCatalog class is a compact table containing the most used properties (Path, Size, PackSize,
+     * MTime, Attrib, CRC, IsDir and Encrypted) of all the items in an archive.
+     *
+     * Each property is stored in its own array (column), and all the paths are stored in a single buffer, so that
+     * the memory needed is much smaller than the one needed by a vector of BitArchiveItem objects, each one with its
+     * own map of properties.
+     *
+     * The other item properties are not stored, but they are retrieved from the archive on request (see getProperty).
+     *
+     * @note BitArchiveCatalog objects can be obtained only through BitArchiveInfo::catalog(), and they do not depend
+     * on the BitArchiveInfo object that created them: they keep a reference to the opened archive (which stays open
+     * as long as the catalog, or any BitArchiveItem using it, exists), so that they remain valid after the
+     * BitArchiveInfo object has been destroyed.
+     *
+     * @note The properties not stored in the catalog must not be retrieved while another operation is being performed
+     * on the archive by the BitArchiveInfo (or BitArchiveReader) object that created the catalog.
+     */
+    class BitArchiveCatalog : public std::enable_shared_from_this< BitArchiveCatalog > {
+        public:
+            /**
+             * @return the number of items in the catalog.
+             */
+            uint32_t itemsCount() const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return the path of the item, or an empty string if not available.
+             */
+            wstring path( uint32_t index ) const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return true if and only if the item is a directory.
+             */
+            bool isDir( uint32_t index ) const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return true if and only if the item is encrypted.
+             */
+            bool isEncrypted( uint32_t index ) const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return the uncompressed size of the item (0 if not available).
+             */
+            uint64_t size( uint32_t index ) const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return the compressed size of the item (0 if not available).
+             */
+            uint64_t packSize( uint32_t index ) const;
+
+            /**
+             * @brief Gets the specified item property: the properties stored by the catalog are read from it, while
+             * the other ones are retrieved from the archive.
+             *
+             * @param index     the index of the item.
+             * @param property  the property to be retrieved.
+             *
+             * @return the value of the item property, if available, or an empty BitPropVariant.
+             */
+            BitPropVariant getProperty( uint32_t index, BitProperty property ) const;
+
+            /**
+             * @return the item properties supported by the archive format which are not stored by the catalog
+             * (see BitArchiveInfo::supportedItemProperties).
+             */
+            const vector< BitProperty >& otherProperties() const;
+
+            /**
+             * @param index the index of the item.
+             *
+             * @return a BitArchiveItem object providing the properties of the item (see getProperty).
+             */
+            BitArchiveItem item( uint32_t index ) const;
+
+            /**
+             * @brief BitArchiveCatalog destructor.
+             */
+            ~BitArchiveCatalog();
+
+            /**
+             * @param property  an item property.
+             *
+             * @return true if and only if the property is stored by BitArchiveCatalog objects.
+             */
+            static bool isStored( BitProperty property );
+
+        private:
+            vector< wchar_t > mPaths;
+            vector< size_t > mPathsOffsets; // the path of the i-th item is in [mPathsOffsets[i], mPathsOffsets[i+1])
+            vector< uint64_t > mSizes;
+            vector< uint64_t > mPackSizes;
+            vector< FILETIME > mModifiedTimes;
+            vector< uint32_t > mAttributes;
+            vector< uint32_t > mCRCs;
+            vector< uint16_t > mFlags; // which properties are available, and the values of the boolean ones
+            map< uint64_t, BitPropVariant > mOtherValues; // values of unexpected types, by (item index, property)
+            vector< BitProperty > mOtherProperties;
+            IInArchive* mInArchive; // referenced, for retrieving the properties not stored in the catalog
+            mutable std::mutex mArchiveMutex;
+
+            BitArchiveCatalog( const BitArchiveInfo& archive, IInArchive* in_archive );
+            void checkIndex( uint32_t index ) const;
+
+            //non-copyable
+            BitArchiveCatalog( const BitArchiveCatalog& other );
+            BitArchiveCatalog& operator=( const BitArchiveCatalog& other );
+
+            friend class BitArchiveInfo;
+    };
+}
+
+#endif // BITARCHIVECATALOG_HPP
@@ -19,14 +19,19 @@
 #ifndef BITARCHIVECREATOR_HPP
 #define BITARCHIVECREATOR_HPP
 
+#include <vector>
+
 #include "../include/bit7zlibrary.hpp"
 #include "../include/bitformat.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/bitcompressionlevel.hpp"
+#include "../include/bitcompressionmethod.hpp"
 #include "../include/bitarchivehandler.hpp"
+#include "../include/bitpropvariant.hpp"
 
 namespace bit7z {
     using std::wstring;
+    using std::vector;
 
     /**
      * @brief Abstract class representing a generic archive creator.
@@ -49,7 +54,7 @@ namespace bit7z {
             /**
              * @return the format used by the archive creator.
              */
-            const BitInOutFormat& compressionFormat();
+            const BitInOutFormat& compressionFormat() const;
 
             /**
              * @return whether the creator crypts also the headers of archives or not
@@ -61,6 +66,57 @@ namespace bit7z {
              */
             BitCompressionLevel compressionLevel() const;
 
+            /**
+             * @return the compression method used by the archive creator.
+             */
+            BitCompressionMethod compressionMethod() const;
+
+            /**
+             * @return the dictionary size (in bytes) used by the archive creator
+             *         (a 0 value means that the default size of the compression level is used).
+             */
+            uint32_t dictionarySize() const;
+
+            /**
+             * @return the word size (i.e. the number of fast bytes, or the model order for PPMd) used by the archive
+             *         creator (a 0 value means that the default size of the compression level is used).
+             */
+            uint32_t wordSize() const;
+
+            /**
+             * @return the maximum size (in bytes) of the solid blocks created by the archive creator
+             *         (a 0 value means that the default size of the compression level is used).
+             */
+            uint64_t solidBlockSize() const;
+
+            /**
+             * @return the maximum number of files in each solid block created by the archive creator
+             *         (a 0 value means no limit).
+             */
+            uint32_t solidBlockFilesCount() const;
+
+            /**
+             * @return the size (in bytes) of the chunks compressed in parallel as independent members of the output
+             *         archive (a 0 value means that the input is compressed as a single stream).
+             */
+            uint64_t chunkSize() const;
+
+            /**
+             * @return the maximum number of input files read in advance by the archive creator
+             *         (a 0 value means that the files are read only when requested by the encoder).
+             */
+            uint32_t readAheadFilesCount() const;
+
+            /**
+             * @return the maximum amount of memory (in bytes) used for the input files read in advance.
+             */
+            uint64_t readAheadMemoryLimit() const;
+
+            /**
+             * @return the way the files to be compressed are read by the archive creator.
+             */
+            BitInputMode sourceInputMode() const;
+
             /**
              * @return whether the archive creator uses solid compression or not.
              */
@@ -72,6 +128,19 @@ namespace bit7z {
              */
             uint64_t volumeSize() const;
 
+            /**
+             * @return the number of threads requested to the archive creator
+             *         (a 0 value means that the number of threads is chosen automatically).
+             */
+            uint32_t threadsCount() const;
+
+            /**
+             * @return the number of threads actually used by the archive creator for the output format, i.e. the
+             *         requested number of threads, or the one computed from the processors available to the process
+             *         (1 if the output format does not support multithreaded compression and no chunk size is set).
+             */
+            uint32_t effectiveThreadsCount() const;
+
             /**
              * @brief Sets up a password for the output archive.
              *
@@ -123,6 +192,59 @@ namespace bit7z {
              */
             void setCompressionLevel( BitCompressionLevel compression_level );
 
+            /**
+             * @brief Sets the compression method to use when creating an archive.
+             *
+             * @note By default, the creator uses the default method of the output format (e.g. LZMA2 for 7z and XZ,
+             * Deflate for ZIP and GZip).
+             *
+             * @param method    the compression method desired.
+             *
+             * @throws BitException if the method is not supported by the output format.
+             */
+            void setCompressionMethod( BitCompressionMethod method );
+
+            /**
+             * @brief Sets the dictionary size to use when creating an archive.
+             *
+             * @note The dictionary size is supported only by the LZMA, LZMA2, BZip2 (block size) and PPMd (model
+             * memory size) methods.
+             *
+             * @param dictionary_size   the dictionary size desired (in bytes, 0 to use the default one).
+             */
+            void setDictionarySize( uint32_t dictionary_size );
+
+            /**
+             * @brief Sets the word size to use when creating an archive.
+             *
+             * @note The word size is the number of fast bytes for the LZMA, LZMA2, Deflate and Deflate64 methods,
+             * and the model order for the PPMd method; it is not supported by the other methods.
+             *
+             * @param word_size the word size desired (0 to use the default one).
+             */
+            void setWordSize( uint32_t word_size );
+
+            /**
+             * @brief Sets the match finder to use when creating an archive.
+             *
+             * @note The match finder is supported only by the LZMA and LZMA2 methods.
+             *
+             * @param match_finder  the match finder desired.
+             */
+            void setMatchFinder( BitMatchFinder match_finder );
+
+            /**
+             * @brief Sets the maximum size of the solid blocks and the maximum number of files in each of them.
+             *
+             * @note These settings have effect only when the solid compression mode is enabled.
+             *
+             * @param block_size    the maximum size (in bytes) of a solid block (0 to use the default one).
+             * @param files_count   the maximum number of files in a solid block (0 means no limit).
+             *
+             * @throws BitException if the output format does not support solid archives.
+             */
+            void setSolidBlockSize( uint64_t block_size, uint32_t files_count = 0 );
+
             /**
              * @brief Sets whether to use solid compression or not.
              *
@@ -141,12 +263,108 @@ namespace bit7z {
              */
             void setVolumeSize( uint64_t size );
 
+            /**
+             * @brief Sets the number of threads to be used when creating an archive.
+             *
+             * @note This setting has effects only with the formats supporting multithreaded compression
+             * (i.e. 7z, XZ, BZip2 and ZIP).
+             *
+             * @param threads_count the number of threads desired (0 means one thread for each processor available
+             *                      to the process).
+             */
+            void setThreadsCount( uint32_t threads_count );
+
+            /**
+             * @brief Sets the number of threads to be used when creating an archive as a fraction of the processors
+             * available to the process (e.g. 0.5 for using half of them).
+             *
+             * @note The effective number of threads is always at least one and at most the number of available
+             * processors.
+             *
+             * @param fraction  the fraction (in the interval (0, 1]) of the available processors to be used.
+             */
+            void setThreadsFraction( double fraction );
+
+            /**
+             * @brief Gets the names and the values of the properties to be set on the archive handler of the output
+             * format, according to the current settings of the creator.
+             *
+             * @param names     the vector where the names of the properties are appended.
+             * @param values    the vector where the values of the properties are appended.
+             *
+             * @throws BitException if a setting is not supported by the compression method.
+             */
+            void archiveProperties( vector< const wchar_t* >& names, vector< BitPropVariant >& values ) const;
+
+            /**
+             * @brief Sets the size of the chunks in which the input is split, each one compressed in parallel into an
+             * independent member (stream) of the output archive; the members are concatenated in the same order of
+             * the chunks, so that the output is still readable by the standard tools (e.g. gzip and bzip2).
+             *
+             * @note This setting is supported only by the formats allowing multiple members (i.e. GZip and BZip2), and
+             * it has effect only when compressing a single file or buffer. The number of chunks compressed
+             * concurrently is given by effectiveThreadsCount(), and each one of them is kept in memory (together with
+             * its compressed data) until its member is written.
+             *
+             * @note When compressing in chunks, the callbacks set to this creator may be called concurrently by
+             * different worker threads, and they refer to the single chunks rather than to the whole input (e.g. the
+             * total notified to the total callback is the size of a chunk).
+             *
+             * @param chunk_size    the size (in bytes) of the chunks (0 to compress the input as a single stream).
+             *
+             * @throws BitException if the output format does not support multiple members.
+             */
+            void setChunkSize( uint64_t chunk_size );
+
+            /**
+             * @brief Sets the number of input files to be read in advance, on background threads, while the encoder
+             * compresses the current one (e.g. to hide the latency of network file systems when compressing many
+             * small files).
+             *
+             * @note The files are read in memory, in the order of the input items, following the last file
+             * requested by the encoder; the files that do not fit the memory limit are read as usual by the encoder.
+             *
+             * @param files_count   the maximum number of files read in advance (0 to disable the read-ahead).
+             * @param memory_limit  the maximum amount of memory (in bytes) used for the files read in advance.
+             */
+            void setReadAhead( uint32_t files_count, uint64_t memory_limit = 32 * 1024 * 1024 );
+
+            /**
+             * @brief Sets the way the files to be compressed are read by the archive creator.
+             *
+             * Memory mapped files are read by the encoder from the system file cache without a system call for each
+             * read request (the data is copied only once, from the mapped view to the buffers of the encoder);
+             * moreover, the pages already compressed are removed from the working set of the process, so that it does
+             * not grow with the amount of data compressed.
+             *
+             * @note Removing the pages from the working set does not evict them from the system file cache: hence,
+             * compressing huge amounts of data may still evict other cached files.
+             *
+             * @note Files that cannot be mapped (e.g. pipes) are read in large blocks.
+             *
+             * @param input_mode    the way the files to be compressed must be read.
+             */
+            void setSourceInputMode( BitInputMode input_mode );
+
         protected:
             const BitInOutFormat& mFormat;
             BitCompressionLevel mCompressionLevel;
+            BitCompressionMethod mCompressionMethod;
+            uint32_t mDictionarySize;
+            uint32_t mWordSize;
+            BitMatchFinder mMatchFinder;
+            bool mMatchFinderSet;
             bool mCryptHeaders;
             bool mSolidMode;
             uint64_t mVolumeSize;
+            uint64_t mSolidBlockSize;
+            uint32_t mSolidBlockFilesCount;
+            uint32_t mThreadsCount;
+            double mThreadsFraction;
+            uint64_t mChunkSize;
+            uint32_t mReadAheadFilesCount;
+            uint64_t mReadAheadMemoryLimit;
+            BitInputMode mSourceInputMode;
     };
 }
 
@@ -24,10 +24,28 @@
 #include "../include/bit7zlibrary.hpp"
 #include "../include/bitarchiveopener.hpp"
 #include "../include/bitarchiveitem.hpp"
+#include "../include/bitarchivecatalog.hpp"
+#include "../include/bittypes.hpp"
+
+#include <functional>
 
 struct IInArchive;
 
 namespace bit7z {
+    /**
+     * @brief The BitArchiveStats struct contains the aggregate statistics of the items in an archive.
+     */
+    struct BitArchiveStats {
+        uint32_t itemsCount;        ///< The number of items in the archive.
+        uint32_t foldersCount;      ///< The number of folders in the archive.
+        uint32_t filesCount;        ///< The number of files in the archive.
+        uint64_t size;              ///< The total uncompressed size of the archive content.
+        uint64_t packSize;          ///< The total compressed size of the archive content.
+        uint64_t maxItemSize;       ///< The uncompressed size of the biggest item in the archive.
+        uint32_t solidBlocksCount;  ///< The number of distinct solid blocks containing the items of the archive.
+        uint32_t encryptedCount;    ///< The number of encrypted items in the archive.
+    };
+
     using std::vector;
 
     /**
@@ -41,8 +59,23 @@ namespace bit7z {
              * @param lib       the 7z library used.
              * @param in_file   the input archive file path.
              * @param format    the input archive format.
+             * @param password  (optional) the password needed to open the archive (e.g. when its headers are encrypted).
+             */
+            BitArchiveInfo( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format,
+                            const wstring& password = L"" );
+
+            /**
+             * @brief Constructs a BitArchiveInfo object, opening the archive contained in the input buffer.
+             *
+             * @note The input buffer is not copied, hence it must outlive this object.
+             *
+             * @param lib       the 7z library used.
+             * @param in_buffer the buffer containing the input archive.
+             * @param format    the input archive format.
+             * @param password  (optional) the password needed to open the archive (e.g. when its headers are encrypted).
              */
-            BitArchiveInfo( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format );
+            BitArchiveInfo( const Bit7zLibrary& lib, const vector< byte_t >& in_buffer, const BitInFormat& format,
+                            const wstring& password = L"" );
 
             /**
              * @brief BitArchiveInfo destructor.
@@ -77,9 +110,47 @@ namespace bit7z {
 
             /**
              * @return a vector of all the archive items as BitArchiveItem objects.
+             *
+             * @note Only the item properties supported by the archive format are retrieved
+             * (see supportedItemProperties). The items are views over the shared catalog of the archive
+             * (see catalog()): the properties not stored in the catalog are retrieved from the archive only when
+             * requested.
              */
             vector< BitArchiveItem > items() const;
 
+            /**
+             * @brief Gets the catalog of the archive items, building it on the first call.
+             *
+             * @return a shared pointer to the catalog of the archive items.
+             */
+            shared_ptr< const BitArchiveCatalog > catalog() const;
+
+            /**
+             * @brief Gets all the archive items, retrieving only the specified properties.
+             *
+             * @param properties    the properties to be retrieved for each item (e.g. Path, Size, MTime and IsDir).
+             *
+             * @return a vector of all the archive items as BitArchiveItem objects.
+             */
+            vector< BitArchiveItem > items( const vector< BitProperty >& properties ) const;
+
+            /**
+             * @brief Visits the archive items one at a time, retrieving their properties only when they are visited.
+             *
+             * Differently from items(), the archive items are not kept in memory all together.
+             *
+             * @param visitor       the function called for each item, which returns false to stop the visit.
+             * @param properties    the properties to be retrieved for each item (if empty, all the supported ones).
+             */
+            void forEachItem( const std::function< bool( const BitArchiveItem& ) >& visitor,
+                              const vector< BitProperty >& properties = vector< BitProperty >() ) const;
+
+            /**
+             * @return the item properties supported by the archive format (as reported by the format handler,
+             * plus Path, IsDir, Size and PackSize which are always included).
+             */
+            vector< BitProperty > supportedItemProperties() const;
+
             /**
              * @return the number of items contained in the archive.
              */
@@ -105,8 +176,28 @@ namespace bit7z {
              */
             uint64_t packSize() const;
 
-        private:
+            /**
+             * @brief Gets the aggregate statistics of the archive items.
+             *
+             * @note The statistics are computed by scanning all the items only on the first call (or on the first call
+             * to foldersCount, filesCount, size or packSize), and then they are cached.
+             *
+             * @return the aggregate statistics of the archive items.
+             */
+            const BitArchiveStats& stats() const;
+
+        protected:
             IInArchive* mInArchive;
+            const wstring mInFile;
+
+        private:
+            mutable BitArchiveStats mStats;
+            mutable bool mStatsComputed;
+            mutable shared_ptr< const BitArchiveCatalog > mCatalog;
+
+            //non-copyable
+            BitArchiveInfo( const BitArchiveInfo& other );
+            BitArchiveInfo& operator=( const BitArchiveInfo& other );
     };
 }
 
@@ -22,15 +22,23 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <memory>
 
 #include "../include/bitpropvariant.hpp"
 
 namespace bit7z {
     using std::wstring;
     using std::map;
+    using std::shared_ptr;
+
+    class BitArchiveCatalog;
 
     /**
      * @brief The BitArchiveItem class represents an item contained in an archive and contains all its properties.
+     *
+     * @note The most used properties (see BitArchiveCatalog) of the items obtained from BitArchiveInfo::items() are not
+     * stored in the item itself, but in a BitArchiveCatalog shared by all the items, while the other properties are
+     * retrieved from the archive only when requested.
      */
     class BitArchiveItem {
         public:
@@ -92,12 +100,16 @@ namespace bit7z {
 
         private:
             const uint32_t mItemIndex;
-            map< BitProperty, BitPropVariant > mItemProperties;
+            shared_ptr< const BitArchiveCatalog > mCatalog;
+            map< BitProperty, BitPropVariant > mItemProperties; // the properties of the items without a catalog
 
             /* BitArchiveItem objects can be created and updated only by BitArchiveReader */
             explicit BitArchiveItem( uint32_t item_index );
+            BitArchiveItem( uint32_t item_index, const shared_ptr< const BitArchiveCatalog >& catalog );
             void setProperty( BitProperty property, const BitPropVariant& value );
+            void setProperty( BitProperty property, BitPropVariant&& value );
             friend class BitArchiveInfo;
+            friend class BitArchiveCatalog;
     };
 }
 
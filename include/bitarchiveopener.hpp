@@ -19,10 +19,48 @@
 #ifndef BITARCHIVEOPENER_HPP
 #define BITARCHIVEOPENER_HPP
 
+#include <cstddef>
+
 #include "../include/bit7zlibrary.hpp"
 #include "../include/bitarchivehandler.hpp"
+#include "../include/bittypes.hpp"
 
 namespace bit7z {
+    using std::wstring;
+    using std::function;
+
+    /**
+     * @brief A std::function whose arguments are the index and the path of an item in the archive, and which returns
+     * true if and only if the item must be processed by the ongoing operation.
+     */
+    typedef function<bool( uint32_t index, const wstring& path )> ItemPredicate;
+
+    /**
+     * @brief The BitItemSink struct represents the destination of the content of an item being extracted.
+     *
+     * @note The write function is called synchronously by the decoder, which waits for it to return before producing
+     * more data: hence, a sink can apply backpressure simply by blocking until it is ready to accept more data.
+     */
+    struct BitItemSink {
+        /**
+         * @brief A std::function consuming a chunk of the content of the item, and returning false if the extraction
+         * must be aborted. If empty, the content of the item is discarded.
+         */
+        function<bool( const byte_t* data, size_t size )> write;
+
+        /**
+         * @brief An (optional) std::function called when the extraction of the item has ended, whose argument is true
+         * if and only if the item has been extracted successfully.
+         */
+        function<void( bool success )> close;
+    };
+
+    /**
+     * @brief A std::function whose arguments are the index, the path and the size of an item being extracted, and which
+     * returns the sink where the content of the item must be written.
+     */
+    typedef function<BitItemSink( uint32_t index, const wstring& path, uint64_t size )> SinkFactory;
+
     /**
      * @brief Abstract class representing a generic archive opener.
      */
@@ -46,8 +84,101 @@ namespace bit7z {
              */
             const BitInFormat& extractionFormat();
 
+            /**
+             * @return the number of threads requested to the decoder of the archive format
+             *         (a 0 value means that the decoder uses its default number of threads).
+             */
+            uint32_t threadsCount() const;
+
+            /**
+             * @return the maximum amount of memory (in bytes) that the decoder of the archive format is allowed to use
+             *         (a 0 value means that the decoder uses its default limit).
+             */
+            uint64_t memoryUsageLimit() const;
+
+            /**
+             * @return the way the archive files are read by the archive opener.
+             */
+            BitInputMode inputMode() const;
+
+            /**
+             * @return the maximum size (in bytes) of the view of a memory mapped archive file
+             *         (a 0 value means the default limit).
+             */
+            uint64_t mappingViewLimit() const;
+
+            /**
+             * @return true if the free space of the output disk is checked before extracting items to the filesystem.
+             */
+            bool freeSpaceCheck() const;
+
+            /**
+             * @brief Sets the number of threads to be used by the decoder of the archive format (e.g. XZ, BZip2 and 7z).
+             *
+             * @note The setting is applied when opening an archive, hence it has no effects on archives already opened
+             * (e.g. by a BitArchiveReader object).
+             *
+             * @note Formats whose decoder does not support multithreading ignore this setting.
+             *
+             * @param threads_count the number of threads desired (0 to use the default number of the decoder).
+             */
+            void setThreadsCount( uint32_t threads_count );
+
+            /**
+             * @brief Sets the maximum amount of memory that the decoder of the archive format is allowed to use
+             * (e.g. for buffering the blocks decoded by multiple threads).
+             *
+             * @note The setting is applied when opening an archive, hence it has no effects on archives already opened
+             * (e.g. by a BitArchiveReader object).
+             *
+             * @note Formats whose decoder does not support a memory usage limit ignore this setting.
+             *
+             * @param memory_limit  the memory limit desired (in bytes, 0 to use the default limit of the decoder).
+             */
+            void setMemoryUsageLimit( uint64_t memory_limit );
+
+            /**
+             * @brief Sets the way the archive files are read by the archive opener.
+             *
+             * Memory mapped archives are read directly from the system file cache, without a system call for each read
+             * request of the decoder (e.g. when extracting few items at random positions of a big archive).
+             * The whole archive is mapped if its size does not exceed the view limit (by default, no limit on 64-bit
+             * systems and 256 MiB on 32-bit ones), otherwise it is accessed through a sliding view of the file.
+             *
+             * @note The setting is applied when opening an archive file, hence it has no effects on archives already
+             * opened (e.g. by a BitArchiveReader object) nor on archives contained in memory buffers.
+             *
+             * @note Errors while reading a memory mapped file (e.g. a disconnected network share or a removed drive)
+             * are reported as read faults only when the library is built with MSVC (which supports structured
+             * exception handling); with other compilers, such errors terminate the process, hence the memory mapped
+             * mode should be used only for archives on local fixed disks.
+             *
+             * @param input_mode        the way the archive files must be read.
+             * @param view_size_limit   the maximum size (in bytes) of the view of a memory mapped archive file
+             *                          (0 to use the default limit).
+             */
+            void setInputMode( BitInputMode input_mode, uint64_t view_size_limit = 0 );
+
+            /**
+             * @brief Sets whether the free space of the output disk must be checked before extracting items to the
+             * filesystem.
+             *
+             * If enabled, a BitException is thrown (before writing anything) when the total size of the items to be
+             * extracted exceeds the space available on the disk of the output directory.
+             *
+             * @note Items whose size is not stored in the archive are not taken into account.
+             *
+             * @param check_free_space  true if the free space must be checked, false otherwise.
+             */
+            void setFreeSpaceCheck( bool check_free_space );
+
         protected:
             const BitInFormat& mFormat;
+            uint32_t mThreadsCount;
+            uint64_t mMemoryUsageLimit;
+            BitInputMode mInputMode;
+            uint64_t mMappingViewLimit;
+            bool mFreeSpaceCheck;
     };
 }
 
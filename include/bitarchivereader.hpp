@@ -0,0 +1,175 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITARCHIVEREADER_HPP
+#define BITARCHIVEREADER_HPP
+
+#include <memory>
+#include <vector>
+
+#include "../include/bitarchiveinfo.hpp"
+#include "../include/bitpathindex.hpp"
+#include "../include/bititemsbuffer.hpp"
+#include "../include/bitchunkedbuffer.hpp"
+#include "../include/bittypes.hpp"
+
+namespace bit7z {
+    using std::wstring;
+    using std::vector;
+
+    /**
+     * @brief The BitArchiveReader class allows to list, extract and test the content of an archive, which is opened
+     * only once (at construction) and kept open until the object is destroyed.
+     *
+     * Differently from BitExtractor, which opens (and parses) the input archive at each operation, a BitArchiveReader
+     * can be used to perform many operations on the same archive without paying the cost of opening it every time.
+     *
+     * @note A BitArchiveReader object is not thread-safe: concurrent operations on the same object must be
+     * synchronized by the user (or performed using different BitArchiveReader objects).
+     */
+    class BitArchiveReader : public BitArchiveInfo {
+        public:
+            /**
+             * @brief Constructs a BitArchiveReader object, opening the input file.
+             *
+             * @param lib       the 7z library used.
+             * @param in_file   the input archive file path.
+             * @param format    the input archive format.
+             * @param password  (optional) the password needed to open the archive (e.g. when its headers are encrypted).
+             */
+            BitArchiveReader( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format,
+                              const wstring& password = L"" );
+
+            /**
+             * @brief Constructs a BitArchiveReader object, opening the archive contained in the input buffer.
+             *
+             * @note The input buffer is not copied, hence it must outlive this object.
+             *
+             * @param lib       the 7z library used.
+             * @param in_buffer the buffer containing the input archive.
+             * @param format    the input archive format.
+             * @param password  (optional) the password needed to open the archive (e.g. when its headers are encrypted).
+             */
+            BitArchiveReader( const Bit7zLibrary& lib, const vector< byte_t >& in_buffer, const BitInFormat& format,
+                              const wstring& password = L"" );
+
+            /**
+             * @brief Extracts the archive into the choosen directory.
+             *
+             * @param out_dir   the output directory where extracted files will be put.
+             */
+            void extract( const wstring& out_dir = L"" ) const;
+
+            /**
+             * @brief Extracts the matching files in the archive into the choosen directory.
+             *
+             * @param item_filter   only files with (archive) paths matching the filter will be extracted.
+             * @param out_dir       the output directory where extracted files will be put.
+             */
+            void extractMatching( const wstring& item_filter, const wstring& out_dir = L"" ) const;
+
+            /**
+             * @brief Extracts the files in the archive matching any of the filters into the choosen directory.
+             *
+             * @param item_filters      only files with (archive) paths matching at least one of the filters will be
+             *                          extracted.
+             * @param out_dir           the output directory where extracted files will be put.
+             * @param case_sensitive    if false, the paths are matched ignoring their case.
+             */
+            void extractMatching( const vector< wstring >& item_filters, const wstring& out_dir = L"",
+                                  bool case_sensitive = true ) const;
+
+            /**
+             * @brief Extracts the specified items in the archive into the choosen directory.
+             *
+             * @param indices   the array of indices of the files in the archive that must be extracted.
+             * @param out_dir   the output directory where extracted files will be put.
+             */
+            void extractItems( const vector< uint32_t >& indices, const wstring& out_dir = L"" ) const;
+
+            /**
+             * @brief Extracts the specified item of the archive into the output buffer.
+             *
+             * @param out_buffer   the output buffer where the content of the item will be put.
+             * @param index        the index of the file to be extracted.
+             */
+            void extract( vector< byte_t >& out_buffer, unsigned int index = 0 ) const;
+
+            /**
+             * @brief Extracts the specified item of the archive into the output chunked buffer.
+             *
+             * @param out_buffer   the output chunked buffer where the content of the item will be appended.
+             * @param index        the index of the file to be extracted.
+             */
+            void extract( BitChunkedBuffer& out_buffer, unsigned int index = 0 ) const;
+
+            /**
+             * @brief Extracts the specified items of the archive into the output items buffer, decoding the archive
+             * only once.
+             *
+             * @param indices   the indices of the files in the archive that must be extracted (if empty, all the files
+             *                  are extracted).
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractItems( const vector< uint32_t >& indices, BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the files of the archive satisfying the predicate into the output items buffer, decoding
+             * the archive only once.
+             *
+             * @param predicate only the files for which the predicate returns true will be extracted.
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractMatching( const ItemPredicate& predicate, BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the specified items of the archive, streaming the content of each one of them to the
+             * sink returned by the given factory.
+             *
+             * @note Directories are skipped, and items whose sink has no write function are decoded but discarded.
+             *
+             * @note The items are extracted (hence, their sinks are created) in the order in which they are stored in
+             * the archive, regardless of the order of the given indices.
+             *
+             * @param sink_factory  the function returning the sink of each extracted item.
+             * @param indices       the indices of the files in the archive that must be extracted (if empty, all the
+             *                      files are extracted).
+             */
+            void extractToSinks( const SinkFactory& sink_factory,
+                                 const vector< uint32_t >& indices = vector< uint32_t >() ) const;
+
+            /**
+             * @brief Tests the archive without extracting its content.
+             *
+             * If the archive is not valid, a BitException is thrown!
+             */
+            void test() const;
+
+            /**
+             * @brief Gets the index of the paths of the items in the archive, building it on the first call.
+             *
+             * @return the index of the paths of the items in the archive.
+             */
+            const BitPathIndex& pathIndex() const;
+
+        private:
+            mutable std::unique_ptr< BitPathIndex > mPathIndex;
+    };
+}
+
+#endif // BITARCHIVEREADER_HPP
@@ -0,0 +1,136 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITCHUNKEDBUFFER_HPP
+#define BITCHUNKEDBUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "../include/bittypes.hpp"
+
+namespace bit7z {
+    using std::vector;
+
+    /**
+     * @brief The BitBufferSegment struct represents a contiguous segment of the content of a BitChunkedBuffer.
+     */
+    struct BitBufferSegment {
+        const byte_t* data; ///< A pointer to the first byte of the segment.
+        size_t size;        ///< The size, in bytes, of the segment.
+    };
+
+    /**
+     * @brief The BitChunkedBuffer class is a growable memory buffer made of fixed-size chunks.
+     *
+     * Differently from a vector, growing the buffer never reallocates nor copies its content: each write fills the
+     * last chunk, allocating new chunks as needed. Hence, the memory used is always about the size of the content,
+     * with no transient peaks (e.g. when outputting big archives or items to memory).
+     *
+     * The content can be accessed without copies as a sequence of segments (see segments()), or copied in a single
+     * contiguous buffer (see coalesce()), which however needs as much memory again as the content.
+     */
+    class BitChunkedBuffer {
+        public:
+            /**
+             * @brief Constructs an empty BitChunkedBuffer object.
+             *
+             * @param chunk_size    the size, in bytes, of the chunks of the buffer.
+             */
+            explicit BitChunkedBuffer( size_t chunk_size = 1024 * 1024 );
+
+            /**
+             * @return the size, in bytes, of the content of the buffer.
+             */
+            size_t size() const;
+
+            /**
+             * @return true if and only if the buffer is empty.
+             */
+            bool empty() const;
+
+            /**
+             * @return the size, in bytes, of the chunks of the buffer.
+             */
+            size_t chunkSize() const;
+
+            /**
+             * @brief Writes the given data at the specified offset of the buffer, overwriting the existing content
+             * and extending the buffer if needed (any gap between the end of the buffer and the offset is zero-filled).
+             *
+             * @param offset    the offset in the buffer where the data must be written.
+             * @param data      the data to be written.
+             * @param size      the size, in bytes, of the data.
+             */
+            void write( size_t offset, const byte_t* data, size_t size );
+
+            /**
+             * @brief Appends the given data to the buffer.
+             *
+             * @param data  the data to be appended.
+             * @param size  the size, in bytes, of the data.
+             */
+            void append( const byte_t* data, size_t size );
+
+            /**
+             * @brief Resizes the buffer, zero-filling the new content (if any) and releasing the chunks not needed
+             * anymore.
+             *
+             * @param size  the new size, in bytes, of the buffer.
+             */
+            void resize( size_t size );
+
+            /**
+             * @brief Empties the buffer, releasing all its chunks.
+             */
+            void clear();
+
+            /**
+             * @brief Gets a scatter-gather view of the content of the buffer.
+             *
+             * @note The returned segments are valid until this object is modified or destroyed.
+             *
+             * @return the segments of the buffer, in order.
+             */
+            vector< BitBufferSegment > segments() const;
+
+            /**
+             * @brief Moves the content of the buffer at the end of the given vector, leaving this buffer empty.
+             *
+             * @note The vector is grown to its final size before copying the chunks, hence the memory used by the
+             * operation peaks at about twice the size of the content (the chunks are released as soon as they have
+             * been copied). For big contents, prefer accessing the segments() of the buffer directly.
+             *
+             * @param out_buffer    the vector where the content of the buffer must be appended.
+             */
+            void coalesce( vector< byte_t >& out_buffer );
+
+        private:
+            size_t mChunkSize;
+            size_t mSize;
+            vector< std::unique_ptr< byte_t[] > > mChunks;
+
+            void grow( size_t size );
+
+            //non-copyable
+            BitChunkedBuffer( const BitChunkedBuffer& other );
+            BitChunkedBuffer& operator=( const BitChunkedBuffer& other );
+    };
+}
+#endif // BITCHUNKEDBUFFER_HPP
@@ -0,0 +1,48 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITCOMPRESSIONMETHOD_HPP
+#define BITCOMPRESSIONMETHOD_HPP
+
+namespace bit7z {
+    /**
+     * @brief The BitCompressionMethod enum represents the compression methods used by 7z when creating archives.
+     * @note Not all the methods are supported by every output format
+     * (https://sevenzip.osdn.jp/chm/cmdline/switches/method.htm).
+     */
+    enum class BitCompressionMethod {
+        Copy,       ///< No compression (all formats)
+        Deflate,    ///< Deflate (ZIP, GZip and 7z)
+        Deflate64,  ///< Deflate64 (ZIP and 7z)
+        BZip2,      ///< BZip2 (BZip2, ZIP and 7z)
+        Lzma,       ///< LZMA (ZIP and 7z)
+        Lzma2,      ///< LZMA2 (XZ and 7z)
+        Ppmd        ///< PPMd (ZIP and 7z)
+    };
+
+    /**
+     * @brief The BitMatchFinder enum represents the match finders used by the LZMA and LZMA2 methods.
+     */
+    enum class BitMatchFinder {
+        BT2,    ///< Binary tree with 2 bytes hashing
+        BT3,    ///< Binary tree with 3 bytes hashing
+        BT4,    ///< Binary tree with 4 bytes hashing
+        HC4     ///< Hash chain with 4 bytes hashing
+    };
+}
+#endif // BITCOMPRESSIONMETHOD_HPP
@@ -27,6 +27,7 @@
 #include "../include/bitformat.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/bitarchivecreator.hpp"
+#include "../include/bitchunkedbuffer.hpp"
 
 namespace bit7z {
     namespace filesystem {
@@ -38,6 +39,15 @@ namespace bit7z {
     using std::map;
     using filesystem::FSItem;
 
+    /**
+     * @brief The BitShard struct describes one of the independent archives created by BitCompressor::compressSharded.
+     */
+    struct BitShard {
+        wstring archivePath;        ///< The path of the shard archive.
+        vector< wstring > items;    ///< The paths (inside the archive) of the items contained in the shard.
+        uint64_t size;              ///< The total uncompressed size of the items contained in the shard.
+    };
+
     /**
      * @brief The BitCompressor class allows to compress files and directories into file archives.
      *
@@ -123,6 +133,63 @@ namespace bit7z {
              */
             void compressDirectory( const wstring& in_dir, const wstring& out_archive ) const;
 
+            /**
+             * @brief Compresses the given files or directories into a ZIP archive, using multiple threads.
+             *
+             * The items are split into groups of consecutive items with similar total size, and each group is
+             * compressed by a worker thread into a temporary archive (with a unique name, in the directory of the
+             * output one); the entries of the temporary archives are then merged, in the same order of the items,
+             * into the output archive.
+             * Since each entry is compressed independently, the output does not depend on the number of threads.
+             *
+             * @note The number of threads is given by effectiveThreadsCount().
+             *
+             * @note The callbacks set to this compressor may be called concurrently by different worker threads.
+             *
+             * @note A single big file is compressed by a single thread, since the entries of a ZIP archive cannot be
+             * split.
+             *
+             * @param in_paths      a vector of paths.
+             * @param out_archive   the path (relative or absolute) to the output archive file.
+             */
+            void compressParallel( const vector< wstring >& in_paths, const wstring& out_archive ) const;
+
+            /**
+             * @brief Compresses the given files or directories into multiple independent archives (shards), which
+             * are created concurrently and can be extracted independently (e.g. in parallel or on different machines).
+             *
+             * The items are grouped by their parent directory and the groups are assigned to the shards balancing the
+             * total size of each shard (the biggest groups first, each one to the smallest shard so far); a group
+             * bigger than the average size of a shard is split among the shards file by file.
+             *
+             * The shards are named after the output archive path, adding their 1-based index before the extension
+             * (e.g. "backup.001.7z", "backup.002.7z", ...). A manifest file (e.g. "backup.manifest") is written along
+             * with them: it is a UTF-8 text file containing, for each item, a line with the file name of its shard and
+             * the path of the item inside the shard, separated by a tab character.
+             *
+             * @note Differently from volumes (see setVolumeSize), each shard is a complete archive; however, the volume
+             * size is still applied to each shard, if set.
+             *
+             * @note The shards are compressed by up to effectiveThreadsCount() threads, which are divided among the
+             * shards being compressed.
+             *
+             * @note The callbacks set to this compressor may be called concurrently by different worker threads,
+             * and they refer to the single shards rather than to the whole set of items.
+             *
+             * @note If a shard file or the manifest already exists, a BitException is thrown before compressing
+             * anything; if the compression of any shard or the writing of the manifest fails, all the shards created
+             * (and the manifest) are deleted. No file is created if there are no items to be compressed.
+             *
+             * @param in_paths      a vector of paths.
+             * @param out_archive   the path (relative or absolute) from which the paths of the shards are derived.
+             * @param shards_count  the maximum number of shards (0 means one shard for each thread); less shards are
+             *                      created if there are not enough items or directories to fill them.
+             *
+             * @return the description of each shard created.
+             */
+            vector< BitShard > compressSharded( const vector< wstring >& in_paths, const wstring& out_archive,
+                                                uint32_t shards_count = 0 ) const;
+
             /* Compression from file system to memory buffer */
 
             /**
@@ -130,14 +197,30 @@ namespace bit7z {
              *
              * @note If the format of the output doesn't support in memory compression, a BitException is thrown.
              *
+             * @note The archive is first written to a BitChunkedBuffer and then copied into the vector, hence the
+             * memory used peaks at about twice the size of the archive: for big archives, prefer the overload taking
+             * a BitChunkedBuffer.
+             *
              * @param in_file           the file to be compressed.
              * @param out_buffer        the buffer going to contain the output archive.
              */
             void compressFile( const wstring& in_file, vector< byte_t >& out_buffer ) const;
 
+            /**
+             * @brief Compresses the input file to the output chunked buffer (which, differently from a vector,
+             * never reallocates its content while the archive is being written).
+             *
+             * @note If the format of the output doesn't support in memory compression, a BitException is thrown.
+             *
+             * @param in_file           the file to be compressed.
+             * @param out_buffer        the chunked buffer where the output archive will be appended.
+             */
+            void compressFile( const wstring& in_file, BitChunkedBuffer& out_buffer ) const;
+
         private:
-            void compressToFileSystem( const vector< FSItem >& in_items, const wstring& out_archive ) const;
-            void compressToMemory( const vector< FSItem >& in_items, vector< byte_t >& out_buffer ) const;
+            void compressToFileSystem( const vector< FSItem >& in_items, const wstring& out_archive,
+                                       uint32_t threads_count = 0 ) const;
+            void compressToMemory( const vector< FSItem >& in_items, BitChunkedBuffer& out_buffer ) const;
     };
 }
 #endif // BITCOMPRESSOR_HPP
@@ -19,6 +19,7 @@
 #ifndef BITEXTRACTOR_HPP
 #define BITEXTRACTOR_HPP
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -26,6 +27,8 @@
 #include "../include/bitguids.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/bitarchiveopener.hpp"
+#include "../include/bititemsbuffer.hpp"
+#include "../include/bitchunkedbuffer.hpp"
 
 struct IInArchive;
 
@@ -33,6 +36,20 @@ namespace bit7z {
     using std::wstring;
     using std::vector;
 
+    /**
+     * @brief The BitWorkerStats struct contains the statistics of a worker thread used in a parallel extraction.
+     */
+    struct BitWorkerStats {
+        uint32_t itemsCount;  ///< The number of items extracted by the worker.
+        uint64_t unpackSize;  ///< The total uncompressed size (in bytes) of the items extracted by the worker.
+        uint64_t elapsedTime; ///< The time (in milliseconds) taken by the worker to extract its items.
+
+        /**
+         * @return the extraction throughput of the worker, in bytes per second.
+         */
+        double throughput() const;
+    };
+
     /**
      * @brief The BitExtractor class allows to extract the content of file archives.
      */
@@ -67,6 +84,18 @@ namespace bit7z {
              */
             void extractMatching( const wstring& in_file, const wstring& item_filter, const wstring& out_dir = L"" ) const;
 
+            /**
+             * @brief Extracts the files in the given archive matching any of the filters into the choosen directory.
+             *
+             * @param in_file           the input archive file.
+             * @param item_filters      only files with (archive) paths matching at least one of the filters will be
+             *                          extracted.
+             * @param out_dir           the output directory where extracted files will be put.
+             * @param case_sensitive    if false, the paths are matched ignoring their case.
+             */
+            void extractMatching( const wstring& in_file, const vector< wstring >& item_filters,
+                                  const wstring& out_dir = L"", bool case_sensitive = true ) const;
+
             /**
              * @brief Extracts the specified items in the given archive into the choosen directory.
 
@@ -76,6 +105,59 @@ namespace bit7z {
              */
             void extractItems( const wstring& in_file, const vector<uint32_t>& indices, const wstring& out_dir = L"" ) const;
 
+            /**
+             * @brief Extracts the given archive into the choosen directory, using multiple threads.
+             *
+             * The archive is opened once for each worker thread and its items are partitioned among the workers
+             * (items belonging to the same solid block are always extracted by the same worker, so that no block is
+             * decoded more than once), balancing the uncompressed size assigned to each one.
+             *
+             * @note The callbacks set to this extractor may be called concurrently by different worker threads.
+             *
+             * @note Archives that cannot be partitioned (e.g. single file or fully solid archives, including the solid
+             * archives whose format does not expose the solid blocks, like RAR) are extracted by a single worker.
+             *
+             * @param in_file       the input archive file.
+             * @param out_dir       the output directory where extracted files will be put.
+             * @param threads_count the maximum number of worker threads to be used (0 means one per hardware thread).
+             *
+             * @return the statistics of each worker thread used for the extraction.
+             */
+            vector< BitWorkerStats > extractParallel( const wstring& in_file, const wstring& out_dir = L"",
+                                                      uint32_t threads_count = 0 ) const;
+
+            /**
+             * @brief Extracts the given multi-member GZip or BZip2 archive (e.g. produced by a parallel compressor)
+             * into the choosen directory, decompressing its members concurrently.
+             *
+             * The boundaries of the members are found by scanning the archive for their signatures, then each member
+             * is decompressed on its own directly from the file, and the results are written in order to the
+             * output file (the member being written is decompressed in streaming, while the outputs of the following
+             * ones are kept in memory until their turn comes).
+             *
+             * @note The callbacks set to this extractor may be called concurrently by different worker threads,
+             * and they refer to the single members rather than to the whole archive.
+             *
+             * @note The whole archive is scanned once before decompressing it. A signature found by chance inside the
+             * compressed data makes the rest of the archive (from the member containing it) be decompressed
+             * sequentially, in streaming, by a single worker; the same happens to archives made of a single member.
+             *
+             * @param in_file       the input archive file.
+             * @param out_dir       the output directory where the extracted file will be put.
+             * @param threads_count the maximum number of worker threads to be used (0 means one per hardware thread).
+             */
+            void extractMembers( const wstring& in_file, const wstring& out_dir = L"", uint32_t threads_count = 0 ) const;
+
+            /**
+             * @brief Extracts the given multi-member GZip or BZip2 archive into the output buffer, decompressing its
+             * members concurrently (see extractMembers( const wstring&, const wstring&, uint32_t )).
+             *
+             * @param in_file       the input archive file.
+             * @param out_buffer    the output buffer where the content of the archive will be put.
+             * @param threads_count the maximum number of worker threads to be used (0 means one per hardware thread).
+             */
+            void extractMembers( const wstring& in_file, vector< byte_t >& out_buffer, uint32_t threads_count = 0 ) const;
+
             /**
              * @brief Extracts the given archive into the output buffer.
 
@@ -85,6 +167,55 @@ namespace bit7z {
              */
             void extract( const wstring& in_file, vector< byte_t >& out_buffer, unsigned int index = 0 );
 
+            /**
+             * @brief Extracts the specified item of the given archive into the output chunked buffer.
+             *
+             * @param in_file      the input archive file.
+             * @param out_buffer   the output chunked buffer where the content of the item will be appended.
+             * @param index        the index of the file to be extracted from in_file.
+             */
+            void extract( const wstring& in_file, BitChunkedBuffer& out_buffer, unsigned int index = 0 ) const;
+
+            /**
+             * @brief Extracts the specified items in the given archive into the output items buffer, decoding the
+             * archive only once.
+             *
+             * @param in_file   the input archive file.
+             * @param indices   the indices of the files in the archive that must be extracted (if empty, all the files
+             *                  are extracted).
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractItems( const wstring& in_file, const vector< uint32_t >& indices,
+                               BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the files in the given archive satisfying the predicate into the output items buffer,
+             * decoding the archive only once.
+             *
+             * @param in_file   the input archive file.
+             * @param predicate only the files for which the predicate returns true will be extracted.
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractMatching( const wstring& in_file, const ItemPredicate& predicate,
+                                  BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the specified items in the given archive, streaming the content of each one of them to
+             * the sink returned by the given factory.
+             *
+             * @note Directories are skipped, and items whose sink has no write function are decoded but discarded.
+             *
+             * @note The items are extracted (hence, their sinks are created) in the order in which they are stored in
+             * the archive, regardless of the order of the given indices.
+             *
+             * @param in_file       the input archive file.
+             * @param sink_factory  the function returning the sink of each extracted item.
+             * @param indices       the indices of the files in the archive that must be extracted (if empty, all the
+             *                      files are extracted).
+             */
+            void extractToSinks( const wstring& in_file, const SinkFactory& sink_factory,
+                                 const vector< uint32_t >& indices = vector< uint32_t >() ) const;
+
             /**
              * @brief Tests the given archive without extracting its content.
              *
@@ -93,10 +224,6 @@ namespace bit7z {
              * @param in_file   the input archive file.
              */
             void test( const wstring& in_file );
-
-        private:
-            void extractToFileSystem( IInArchive* in_archive, const wstring& in_file,
-                                      const wstring& out_dir, const vector<uint32_t>& indices ) const;
     };
 }
 #endif // BITEXTRACTOR_HPP
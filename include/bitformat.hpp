@@ -24,7 +24,7 @@
 
 #include "../include/bitguids.hpp"
 
-#define FEATURES_COUNT 6
+#define FEATURES_COUNT 8
 
 namespace bit7z {
     using std::wstring;
@@ -40,6 +40,8 @@ namespace bit7z {
         ENCRYPTION        = 1 << 3,///< The format supports archive encryption (2^3 = 001000)
         HEADER_ENCRYPTION = 1 << 4,///< The format can encrypt the file names (2^4 = 010000)
         INMEM_COMPRESSION = 1 << 5,///< The format is able to create archives in-memory (2^5 = 100000)
+        MULTITHREADING    = 1 << 6,///< The format can use multiple threads for compression (2^6 = 1000000)
+        MULTIPLE_MEMBERS  = 1 << 7,///< The format allows concatenating independently compressed streams (2^7 = 10000000)
     };
 
     /**
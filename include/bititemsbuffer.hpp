@@ -0,0 +1,112 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITITEMSBUFFER_HPP
+#define BITITEMSBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../include/bittypes.hpp"
+
+namespace bit7z {
+    using std::vector;
+
+    /**
+     * @brief The BitItemsBuffer class holds the content of many items extracted from an archive.
+     *
+     * The contents of all the items are stored one after the other in a single contiguous buffer (the arena),
+     * and each item is identified by its offset and size in it.
+     */
+    class BitItemsBuffer {
+        public:
+            /**
+             * @brief Constructs an empty BitItemsBuffer object.
+             */
+            BitItemsBuffer();
+
+            /**
+             * @return the buffer containing the contents of all the items.
+             */
+            const vector< byte_t >& data() const;
+
+            /**
+             * @return the number of items whose content is held by this object.
+             */
+            uint32_t itemsCount() const;
+
+            /**
+             * @return the (ascending) indices in the archive of the items whose content is held by this object.
+             */
+            vector< uint32_t > indices() const;
+
+            /**
+             * @param index the index in the archive of an item.
+             *
+             * @return true if and only if the content of the item is held by this object.
+             */
+            bool contains( uint32_t index ) const;
+
+            /**
+             * @brief Gets the content of the specified item.
+             *
+             * @note The returned pointer is valid until this object is modified or destroyed.
+             *
+             * @param index the index in the archive of the item.
+             *
+             * @return a pointer to the first byte of the content of the item (nullptr if the item is empty).
+             */
+            const byte_t* itemData( uint32_t index ) const;
+
+            /**
+             * @param index the index in the archive of the item.
+             *
+             * @return the size, in bytes, of the content of the item.
+             */
+            size_t itemSize( uint32_t index ) const;
+
+            /**
+             * @brief Reserves the space for the contents of the items (e.g. before an extraction).
+             *
+             * @param size  the total size, in bytes, of the contents of the items.
+             */
+            void reserve( size_t size );
+
+            /**
+             * @brief Removes the contents of all the items.
+             */
+            void clear();
+
+        private:
+            struct ItemSpan {
+                uint32_t index;
+                size_t offset;
+                size_t size;
+            };
+
+            vector< byte_t > mData;
+            vector< ItemSpan > mSpans;
+
+            const ItemSpan& span( uint32_t index ) const;
+
+            friend class MemExtractCallback;
+    };
+}
+
+#endif // BITITEMSBUFFER_HPP
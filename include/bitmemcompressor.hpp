@@ -26,6 +26,7 @@
 #include "../include/bitformat.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/bitarchivecreator.hpp"
+#include "../include/bitchunkedbuffer.hpp"
 
 namespace bit7z {
     using std::wstring;
@@ -66,12 +67,29 @@ namespace bit7z {
              *
              * @note If the format of the output doesn't support in memory compression, a BitException is thrown.
              *
+             * @note The archive is first written to a BitChunkedBuffer and then copied into the vector, hence the
+             * memory used peaks at about twice the size of the archive: for big archives, prefer the overload taking
+             * a BitChunkedBuffer.
+             *
              * @param in_buffer         the buffer to be compressed.
              * @param out_buffer        the buffer going to contain the output archive.
              * @param in_buffer_name    (optional) the buffer name used to give a name to the content of the archive.
              */
             void compress( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
                            const wstring& in_buffer_name = L"" ) const;
+
+            /**
+             * @brief Compresses the given input buffer to the output chunked buffer (which, differently from a vector,
+             * never reallocates its content while the archive is being written).
+             *
+             * @note If the format of the output doesn't support in memory compression, a BitException is thrown.
+             *
+             * @param in_buffer         the buffer to be compressed.
+             * @param out_buffer        the chunked buffer where the output archive will be appended.
+             * @param in_buffer_name    (optional) the buffer name used to give a name to the content of the archive.
+             */
+            void compress( const vector< byte_t >& in_buffer, BitChunkedBuffer& out_buffer,
+                           const wstring& in_buffer_name = L"" ) const;
     };
 }
 #endif // BITMEMCOMPRESSOR_HPP
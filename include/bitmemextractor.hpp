@@ -26,6 +26,8 @@
 #include "../include/bitguids.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/bitarchiveopener.hpp"
+#include "../include/bititemsbuffer.hpp"
+#include "../include/bitchunkedbuffer.hpp"
 
 namespace bit7z {
     using std::wstring;
@@ -65,6 +67,73 @@ namespace bit7z {
              */
             void extract( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
                           unsigned int index = 0 ) const;
+
+            /**
+             * @brief Extracts the specified item of the given buffer archive into the output chunked buffer.
+             *
+             * @param in_buffer    the buffer containing the archive to be extracted.
+             * @param out_buffer   the output chunked buffer where the content of the item will be appended.
+             * @param index        the index of the file to be extracted from in_buffer.
+             */
+            void extract( const vector< byte_t >& in_buffer, BitChunkedBuffer& out_buffer,
+                          unsigned int index = 0 ) const;
+
+            /**
+             * @brief Extracts the specified items in the given buffer archive into the output items buffer, decoding
+             * the archive only once.
+             *
+             * @param in_buffer the buffer containing the archive to be extracted.
+             * @param indices   the indices of the files in the archive that must be extracted (if empty, all the files
+             *                  are extracted).
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractItems( const vector< byte_t >& in_buffer, const vector< uint32_t >& indices,
+                               BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the files in the given buffer archive satisfying the predicate into the output items
+             * buffer, decoding the archive only once.
+             *
+             * @param in_buffer the buffer containing the archive to be extracted.
+             * @param predicate only the files for which the predicate returns true will be extracted.
+             * @param out_items the output buffer where the contents of the extracted files will be put.
+             */
+            void extractMatching( const vector< byte_t >& in_buffer, const ItemPredicate& predicate,
+                                  BitItemsBuffer& out_items ) const;
+
+            /**
+             * @brief Extracts the specified items in the given buffer archive, streaming the content of each one of
+             * them to the sink returned by the given factory.
+             *
+             * @note Directories are skipped, and items whose sink has no write function are decoded but discarded.
+             *
+             * @note The items are extracted (hence, their sinks are created) in the order in which they are stored in
+             * the archive, regardless of the order of the given indices.
+             *
+             * @param in_buffer     the buffer containing the archive to be extracted.
+             * @param sink_factory  the function returning the sink of each extracted item.
+             * @param indices       the indices of the files in the archive that must be extracted (if empty, all the
+             *                      files are extracted).
+             */
+            void extractToSinks( const vector< byte_t >& in_buffer, const SinkFactory& sink_factory,
+                                 const vector< uint32_t >& indices = vector< uint32_t >() ) const;
+
+            /**
+             * @brief Extracts the given multi-member GZip or BZip2 buffer archive (e.g. produced by a parallel
+             * compressor) into the output buffer, decompressing its members concurrently.
+             *
+             * The boundaries of the members are found by scanning the input buffer for their signatures, then each
+             * member is decompressed on its own and the results are appended in order to the output buffer.
+             *
+             * @note The callbacks set to this extractor may be called concurrently by different worker threads,
+             * and they refer to the single members rather than to the whole archive.
+             *
+             * @param in_buffer     the buffer containing the archive to be extracted.
+             * @param out_buffer    the output buffer where the content of the archive will be put.
+             * @param threads_count the maximum number of worker threads to be used (0 means one per hardware thread).
+             */
+            void extractMembers( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
+                                 uint32_t threads_count = 0 ) const;
     };
 }
 
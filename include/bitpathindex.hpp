@@ -0,0 +1,114 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef BITPATHINDEX_HPP
+#define BITPATHINDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bit7z {
+    using std::wstring;
+    using std::vector;
+
+    class BitArchiveInfo;
+
+    /**
+     * @brief The BitPathIndex class is an index of the paths of the items in an archive, allowing to find an item or
+     * to list the content of a directory without scanning all the items of the archive.
+     *
+     * The index is a tree whose nodes are the components of the paths (interned, so that each distinct name is stored
+     * only once), hence a lookup costs O(depth) hash lookups. Both '\\' and '/' are accepted as path separators.
+     *
+     * @note Directories which are not stored as items in the archive (e.g. in some ZIP archives) are part of the index
+     * anyway, but they have no item index.
+     */
+    class BitPathIndex {
+        public:
+            /**
+             * @brief Constructs a BitPathIndex object, indexing the paths of all the items in the given archive.
+             *
+             * @param archive   the archive whose items must be indexed.
+             */
+            explicit BitPathIndex( const BitArchiveInfo& archive );
+
+            /**
+             * @brief Finds the item with the given path.
+             *
+             * @param path              the path of the item in the archive.
+             * @param index             the variable where the index of the item will be put, if found.
+             * @param case_sensitive    if false, the path is compared ignoring its case.
+             *
+             * @return true if and only if an item with the given path has been found.
+             */
+            bool find( const wstring& path, uint32_t& index, bool case_sensitive = true ) const;
+
+            /**
+             * @param path              a path in the archive.
+             * @param case_sensitive    if false, the path is compared ignoring its case.
+             *
+             * @return true if and only if the path is a directory in the archive (i.e., it contains some item).
+             */
+            bool isDirectory( const wstring& path, bool case_sensitive = true ) const;
+
+            /**
+             * @brief Lists the names of the items (files and directories) contained in the given directory.
+             *
+             * @param dir_path          the path of the directory in the archive (an empty path is the archive root).
+             * @param case_sensitive    if false, the path is compared ignoring its case.
+             *
+             * @return the names of the items contained in the directory (empty if the directory does not exist).
+             */
+            vector< wstring > directoryNames( const wstring& dir_path, bool case_sensitive = true ) const;
+
+            /**
+             * @brief Lists the indices of the items contained in the given directory.
+             *
+             * @param dir_path          the path of the directory in the archive (an empty path is the archive root).
+             * @param recursive         if true, also the items in the sub-directories are listed.
+             * @param case_sensitive    if false, the path is compared ignoring its case.
+             *
+             * @return the indices of the items contained in the directory (empty if the directory does not exist).
+             */
+            vector< uint32_t > directoryItems( const wstring& dir_path, bool recursive = false,
+                                               bool case_sensitive = true ) const;
+
+        private:
+            struct Node {
+                uint32_t name;       // id of the (interned) name of the node
+                uint32_t itemIndex;  // index of the corresponding item in the archive (if any)
+                vector< uint32_t > children;
+            };
+
+            vector< wstring > mNames;
+            std::unordered_map< wstring, uint32_t > mNamesIds;
+            vector< uint32_t > mFoldedNames; // id of the case-folded version of each name
+            vector< Node > mNodes;
+            std::unordered_map< uint64_t, uint32_t > mChildren;       // (parent node, name) -> child node
+            std::unordered_map< uint64_t, uint32_t > mFoldedChildren; // (parent node, folded name) -> child node
+
+            uint32_t internName( const wstring& name );
+            uint32_t addNode( uint32_t parent, uint32_t name );
+            bool findNode( const wstring& path, bool case_sensitive, uint32_t& node ) const;
+            bool findName( const wstring& name, uint32_t& name_id ) const;
+    };
+}
+
+#endif // BITPATHINDEX_HPP
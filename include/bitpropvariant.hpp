@@ -422,6 +422,20 @@ namespace bit7z {
              */
             wstring getString() const;
 
+            /**
+             * @return a pointer to the characters of the string value of this variant, without copying them
+             * (it throws an exception if the variant is not a string).
+             *
+             * @note The returned pointer is valid until this variant is modified or destroyed.
+             */
+            const wchar_t* getStringData() const;
+
+            /**
+             * @return the length (in characters) of the string value of this variant
+             * (it throws an exception if the variant is not a string).
+             */
+            size_t getStringLength() const;
+
             /**
              * @return the 8-bit unsigned integer value of this variant
              * (it throws an exception if the variant is not an 8-bit unsigned integer).
@@ -551,6 +565,16 @@ namespace bit7z {
              */
             void clear();
 
+            /**
+             * @brief Moves the value of this variant into the given PROPVARIANT (e.g. an output parameter of the 7z
+             * interfaces), without copying it. After the call, this variant is empty.
+             *
+             * @note The destination PROPVARIANT must be empty, and the caller becomes responsible for freeing it.
+             *
+             * @param destination   the PROPVARIANT where to move the value of this variant.
+             */
+            void detach( PROPVARIANT* destination ) NOEXCEPT;
+
         private:
             void internalClear();
 
@@ -24,5 +24,14 @@ namespace bit7z {
      * @brief A type representing a byte (equivalent to an unsigned char).
      */
     typedef unsigned char byte_t;
+
+    /**
+     * @brief The BitInputMode enum represents the ways an input file (e.g. an archive to be extracted or a file to be
+     * compressed) can be read.
+     */
+    enum class BitInputMode {
+        FileStream,  ///< The file is read through file read calls.
+        MemoryMapped ///< The file is read through a read-only memory mapping of the file.
+    };
 }
 #endif // BITTYPES_HPP
@@ -0,0 +1,60 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef CBUFFEREDINSTREAM_HPP
+#define CBUFFEREDINSTREAM_HPP
+
+#include <string>
+#include <vector>
+
+#include <Windows.h>
+
+#include "../include/bittypes.hpp"
+
+#include "7zip/IStream.h"
+#include "Common/MyCom.h"
+
+namespace bit7z {
+    using std::wstring;
+    using std::vector;
+
+    /* Sequential input stream reading a file in large blocks (whatever the size of the reads of the encoder), used for
+     * the files that cannot be memory mapped (e.g. pipes and devices). */
+    class CBufferedInStream : public ISequentialInStream, public CMyUnknownImp {
+        public:
+            explicit CBufferedInStream( uint32_t buffer_size = 1024 * 1024 );
+            virtual ~CBufferedInStream();
+
+            bool Open( const wstring& path );
+
+            MY_UNKNOWN_IMP
+
+            STDMETHOD( Read )( void* data, UInt32 size, UInt32 * processedSize );
+
+        private:
+            HANDLE mFile;
+            vector< byte_t > mBuffer;
+            size_t mBufferPosition;
+            size_t mBufferEnd;
+
+            //non-copyable
+            CBufferedInStream( const CBufferedInStream& other );
+            CBufferedInStream& operator=( const CBufferedInStream& other );
+    };
+}
+#endif // CBUFFEREDINSTREAM_HPP
@@ -0,0 +1,83 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef CMAPPEDINSTREAM_HPP
+#define CMAPPEDINSTREAM_HPP
+
+#include <string>
+
+#include <Windows.h>
+
+#include "../include/bittypes.hpp"
+
+#include "7zip/IStream.h"
+#include "Common/MyCom.h"
+
+namespace bit7z {
+    using std::wstring;
+
+    /* Input stream reading a file through a read-only memory mapping, so that reads are served directly from the
+     * system file cache without a system call each.
+     * Files bigger than the view size limit are mapped through a sliding view (whose offset is aligned to the
+     * allocation granularity), which is remapped whenever a read falls outside it.
+     * In sequential mode, the file is opened with the sequential scan hint and the pages following the read position
+     * are prefetched in the background; in random mode, the file is opened with the random access hint and no
+     * prefetch is performed.
+     * In drop-behind mode (meant for files read only once, e.g. the sources of an archive), the pages already consumed
+     * are removed from the working set of the process, so that it does not grow with the size of the file (the pages
+     * are still kept in the system file cache, though). */
+    class CMappedInStream : public IInStream, public IStreamGetSize, public CMyUnknownImp {
+        public:
+            CMappedInStream();
+            virtual ~CMappedInStream();
+
+            bool Open( const wstring& path, bool sequential_access, uint64_t max_view_size = 0,
+                       bool drop_behind = false );
+
+            MY_UNKNOWN_IMP2( IInStream, IStreamGetSize )
+
+            STDMETHOD( Read )( void* data, UInt32 size, UInt32 * processedSize );
+            STDMETHOD( Seek )( Int64 offset, UInt32 seekOrigin, UInt64 * newPosition );
+            STDMETHOD( GetSize )( UInt64 * size );
+
+        private:
+            HANDLE mFile;
+            HANDLE mMapping;
+            const byte_t* mView;
+            uint64_t mViewOffset;
+            uint64_t mViewSize;
+            uint64_t mMaxViewSize;
+            uint64_t mSize;
+            uint64_t mPosition;
+            uint64_t mPrefetchedEnd;
+            uint64_t mDroppedEnd;
+            bool mSequentialAccess;
+            bool mDropBehind;
+
+            bool mapView( uint64_t offset );
+            void unmapView();
+            void prefetch();
+            void dropBehind();
+            void close();
+
+            //non-copyable
+            CMappedInStream( const CMappedInStream& other );
+            CMappedInStream& operator=( const CMappedInStream& other );
+    };
+}
+#endif // CMAPPEDINSTREAM_HPP
@@ -29,16 +29,26 @@
 namespace bit7z {
     using std::vector;
 
-    class COutMemStream : public ISequentialOutStream, public CMyUnknownImp {
+    /* Output stream writing to a growable memory buffer.
+     * The stream is seekable (so that format handlers like 7z and ZIP can go back and patch the headers they have
+     * already written): positions are relative to the size the buffer had when the stream was created, hence the
+     * previous content of the buffer is never overwritten. */
+    class COutMemStream : public IOutStream, public CMyUnknownImp {
         public:
             explicit COutMemStream( vector< byte_t >& out_buffer );
             virtual ~COutMemStream();
 
             vector< byte_t >& mBuffer;
 
-            MY_UNKNOWN_IMP
+            MY_UNKNOWN_IMP1( IOutStream )
 
             STDMETHOD( Write )( const void* data, UInt32 size, UInt32 * processedSize );
+            STDMETHOD( Seek )( Int64 offset, UInt32 seekOrigin, UInt64 * newPosition );
+            STDMETHOD( SetSize )( UInt64 newSize );
+
+        private:
+            const size_t mOrigin;
+            size_t mPosition;
     };
 }
 #endif // COUTMEMSTREAM_HPP
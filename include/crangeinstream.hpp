@@ -0,0 +1,52 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef CRANGEINSTREAM_HPP
+#define CRANGEINSTREAM_HPP
+
+#include <cstdint>
+
+#include "7zip/IStream.h"
+#include "Common/MyCom.h"
+
+namespace bit7z {
+    /* Input stream exposing the range [begin, begin + size) of another input stream as a stream on its own (e.g. a
+     * single member of a multi-member GZip file), without copying it. */
+    class CRangeInStream : public IInStream, public CMyUnknownImp {
+        public:
+            CRangeInStream( IInStream* in_stream, uint64_t begin, uint64_t size );
+            virtual ~CRangeInStream();
+
+            MY_UNKNOWN_IMP1( IInStream )
+
+            STDMETHOD( Read )( void* data, UInt32 size, UInt32 * processedSize );
+            STDMETHOD( Seek )( Int64 offset, UInt32 seekOrigin, UInt64 * newPosition );
+
+        private:
+            CMyComPtr< IInStream > mStream;
+            const uint64_t mBegin;
+            const uint64_t mSize;
+            uint64_t mPosition;
+            uint64_t mStreamPosition; // the position of the underlying stream, relative to mBegin
+
+            //non-copyable
+            CRangeInStream( const CRangeInStream& other );
+            CRangeInStream& operator=( const CRangeInStream& other );
+    };
+}
+#endif // CRANGEINSTREAM_HPP
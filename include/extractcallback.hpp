@@ -76,6 +76,7 @@ namespace bit7z {
 
             COutFileStream* mOutFileStreamSpec;
             CMyComPtr< ISequentialOutStream > mOutFileStream;
+            UInt64 mPreallocatedSize; // size reserved in advance for the current output file (0 if none)
 
             UInt64 mNumErrors;
     };
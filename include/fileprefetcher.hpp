@@ -0,0 +1,85 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef FILEPREFETCHER_HPP
+#define FILEPREFETCHER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "7zip/Common/StreamObjects.h"
+#include "7zip/IStream.h"
+#include "Common/MyCom.h"
+
+#include "../include/fsitem.hpp"
+
+namespace bit7z {
+    using std::vector;
+    using filesystem::FSItem;
+
+    /* Reads in memory, on background threads, the content of the files following the last one requested by the
+     * encoder (in the order of the items), so that the encoder does not wait for opening and reading each file.
+     * At most window_size files are prefetched at the same time, and their total size never exceeds memory_limit:
+     * the files that do not fit (or that fail to be read) are not prefetched, and they must be opened as usual. */
+    class FilePrefetcher {
+        public:
+            FilePrefetcher( const vector< FSItem >& items, uint32_t window_size, uint64_t memory_limit );
+            ~FilePrefetcher();
+
+            /* Returns a stream over the content of the item if it has been prefetched (waiting for it if it is being
+             * read), or nullptr otherwise; in any case, the prefetching window is moved after the given index. */
+            CMyComPtr< ISequentialInStream > takeStream( uint32_t index );
+
+        private:
+            enum class EntryState { Queued, Reading, Ready, Failed };
+
+            struct Entry {
+                EntryState state;
+                bool discarded;
+                uint64_t size;
+                CMyComPtr< CReferenceBuf > buffer;
+            };
+
+            const vector< FSItem >& mItems;
+            const uint32_t mWindowSize;
+            const uint64_t mMemoryLimit;
+            uint64_t mMemoryUsed;
+            bool mStopping;
+
+            std::map< uint32_t, Entry > mEntries;
+            std::deque< uint32_t > mQueue;
+            std::mutex mMutex;
+            std::condition_variable mWorkAvailable;
+            std::condition_variable mEntryDone;
+            vector< std::thread > mWorkers;
+
+            void moveWindow( uint32_t first_index );
+            void workerLoop();
+            bool readFile( const FSItem& item, CReferenceBuf* buffer );
+
+            //non-copyable
+            FilePrefetcher( const FilePrefetcher& other );
+            FilePrefetcher& operator=( const FilePrefetcher& other );
+    };
+}
+#endif // FILEPREFETCHER_HPP
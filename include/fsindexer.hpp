@@ -24,6 +24,7 @@
 #include <map>
 
 #include "../include/fsitem.hpp"
+#include "../include/fsutil.hpp"
 
 namespace bit7z {
     namespace filesystem {
@@ -40,6 +41,7 @@ namespace bit7z {
             private:
                 FSItem mDirItem;
                 wstring mFilter;
+                WildcardMatcher mMatcher;
 
                 FSIndexer( const wstring& directory, const wstring& filter = L"" );
                 void listDirectoryItems( vector< FSItem >& result, bool recursive, const wstring& prefix = L"" );
@@ -20,9 +20,46 @@
 #define FSUTIL_HPP
 
 #include <iostream>
+#include <map>
+#include <unordered_set>
+#include <vector>
 
 namespace bit7z {
     namespace filesystem {
+        using std::wstring;
+        using std::vector;
+
+        /* Matches strings against a set of wildcard patterns ('*' matches any sequence of characters, '?' matches any
+         * single character), which are compiled once at construction.
+         * Plain patterns (e.g. "file.txt"), prefix patterns (e.g. "dir*") and suffix patterns (e.g. "*.txt") are
+         * matched with hash lookups; the other patterns are split on '*' and their segments are searched greedily
+         * (without backtracking) after checking the minimum length and the anchored prefix/suffix. */
+        class WildcardMatcher {
+            public:
+                explicit WildcardMatcher( const wstring& pattern, bool case_sensitive = true );
+                explicit WildcardMatcher( const vector< wstring >& patterns, bool case_sensitive = true );
+
+                bool matches( const wstring& str ) const;
+
+            private:
+                struct Pattern {
+                    vector< wstring > segments;
+                    bool anchoredStart;
+                    bool anchoredEnd;
+                    size_t minLength;
+                };
+
+                bool mCaseSensitive;
+                bool mMatchesAll;
+                std::unordered_set< wstring > mLiterals;
+                std::map< size_t, std::unordered_set< wstring > > mPrefixes; // grouped by length
+                std::map< size_t, std::unordered_set< wstring > > mSuffixes; // grouped by length
+                vector< Pattern > mPatterns;
+
+                void addPattern( const wstring& pattern );
+                static bool matchesPattern( const Pattern& pattern, const wstring& str );
+        };
+
         namespace fsutil {
             using std::wstring;
 
@@ -33,9 +70,11 @@ namespace bit7z {
             //bool has_ending( const wstring& str, const wstring& ending );
 
             void normalize_path( wstring& path );
+            wstring absolute_path( const wstring& path );
             wstring dirname( const wstring& path );
             wstring filename( const wstring& path, bool ext = false );
             wstring extension( const wstring& path );
+            wstring fold_case( const wstring& str );
             bool wildcard_match( const wstring& pattern, const wstring& str );
         }
     }
@@ -29,11 +29,13 @@
 #include "Common/MyCom.h"
 
 #include "../include/coutmemstream.hpp"
+#include "../include/bitchunkedbuffer.hpp"
 #include "../include/bitguids.hpp"
 #include "../include/bitformat.hpp"
 #include "../include/bittypes.hpp"
 #include "../include/callback.hpp"
 #include "../include/bitarchiveopener.hpp"
+#include "../include/bititemsbuffer.hpp"
 
 namespace bit7z {
     using std::vector;
@@ -41,6 +43,8 @@ namespace bit7z {
     class MemExtractCallback : public IArchiveExtractCallback, ICryptoGetTextPassword, CMyUnknownImp, public Callback {
         public:
             MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler, vector< byte_t >& buffer );
+            MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler, BitItemsBuffer& items );
+            MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler, BitChunkedBuffer& buffer );
             virtual ~MemExtractCallback();
 
             MY_UNKNOWN_IMP1( ICryptoGetTextPassword )
@@ -60,7 +64,13 @@ namespace bit7z {
         private:
             const BitArchiveOpener& mOpener;
             CMyComPtr< IInArchive > mArchiveHandler;
-            vector< byte_t >& mBuffer;
+            vector< byte_t >* mBuffer; // if not null, the content of each item is appended to it
+            BitItemsBuffer* mItemsBuffer; // if not null, mBuffer is its arena and each item gets its own span
+            /* If not null, the content is written to this chunked buffer: when extracting to a vector, it is the
+             * internal one, which is then coalesced into the vector (avoiding the reallocations of the vector). */
+            BitChunkedBuffer* mChunkedBuffer;
+            BitChunkedBuffer mItemChunks;
+            size_t mCurrentSpan;
             bool mExtractMode;
             struct CProcessedFileInfo {
                 FILETIME MTime;
@@ -70,10 +80,11 @@ namespace bit7z {
                 bool MTimeDefined;
             } mProcessedFileInfo;
 
-            COutMemStream* mOutMemStreamSpec;
             CMyComPtr< ISequentialOutStream > mOutMemStream;
 
             UInt64 mNumErrors;
+
+            bool reserveBuffer( uint64_t item_size );
     };
 }
 #endif // MEMEXTRACTCALLBACK_HPP
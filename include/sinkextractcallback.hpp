@@ -0,0 +1,67 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef SINKEXTRACTCALLBACK_HPP
+#define SINKEXTRACTCALLBACK_HPP
+
+#include "7zip/Archive/IArchive.h"
+#include "7zip/IPassword.h"
+#include "Common/MyCom.h"
+
+#include "../include/coutsinkstream.hpp"
+#include "../include/callback.hpp"
+#include "../include/bitarchiveopener.hpp"
+
+namespace bit7z {
+    class SinkExtractCallback : public IArchiveExtractCallback, ICryptoGetTextPassword, CMyUnknownImp, public Callback {
+        public:
+            SinkExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler,
+                                 const SinkFactory& sinkFactory );
+            virtual ~SinkExtractCallback();
+
+            MY_UNKNOWN_IMP1( ICryptoGetTextPassword )
+
+            // IProgress
+            STDMETHOD( SetTotal )( UInt64 size );
+            STDMETHOD( SetCompleted )( const UInt64 * completeValue );
+
+            // IArchiveExtractCallback
+            STDMETHOD( GetStream )( UInt32 index, ISequentialOutStream * *outStream, Int32 askExtractMode );
+            STDMETHOD( PrepareOperation )( Int32 askExtractMode );
+            STDMETHOD( SetOperationResult )( Int32 resultEOperationResult );
+
+            // ICryptoGetTextPassword
+            STDMETHOD( CryptoGetTextPassword )( BSTR * aPassword );
+
+        private:
+            const BitArchiveOpener& mOpener;
+            CMyComPtr< IInArchive > mArchiveHandler;
+            const SinkFactory& mSinkFactory;
+
+            BitItemSink mSink; // the sink of the item currently being extracted
+            bool mSinkOpened;
+
+            COutSinkStream* mOutSinkStreamSpec;
+            CMyComPtr< ISequentialOutStream > mOutSinkStream;
+
+            UInt64 mNumErrors;
+
+            void closeSink( bool success );
+    };
+}
+#endif // SINKEXTRACTCALLBACK_HPP
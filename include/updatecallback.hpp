@@ -24,7 +24,10 @@
 #include "7zip/IPassword.h"
 #include "Common/MyCom.h"
 
+#include <memory>
+
 #include "../include/fsindexer.hpp"
+#include "../include/fileprefetcher.hpp"
 #include "../include/callback.hpp"
 #include "../include/bitarchivecreator.hpp"
 
@@ -78,6 +81,8 @@ namespace bit7z {
             bool mAskPassword;
 
             bool mNeedBeClosed;
+
+            std::unique_ptr< FilePrefetcher > mPrefetcher;
     };
 }
 #endif // UPDATECALLBACK_HPP
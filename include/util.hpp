@@ -19,25 +19,134 @@
 #ifndef UTIL_HPP
 #define UTIL_HPP
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 #include "7zip/Archive/IArchive.h"
 #include "7zip/Common/FileStreams.h"
 
 #include "../include/bit7zlibrary.hpp"
+#include "../include/bitarchivecreator.hpp"
 #include "../include/bitcompressionlevel.hpp"
 #include "../include/bitarchiveopener.hpp"
+#include "../include/bititemsbuffer.hpp"
+#include "../include/bitchunkedbuffer.hpp"
+#include "../include/bittypes.hpp"
 
 namespace bit7z {
     namespace util {
-        CMyComPtr< IOutArchive > initOutArchive( const Bit7zLibrary& lib, const BitInOutFormat& format,
-                const BitCompressionLevel compressionLevel,
-                const bool cryptHeaders, const bool solidMode );
+        /* A function filling the (already sized) buffer in its second argument with the input data starting at the
+         * offset in its first argument. */
+        typedef std::function< void( uint64_t, std::vector< byte_t >& ) > ChunkReader;
+
+        /* Returns a ChunkReader reading from the input stream, which can be called concurrently (the reads are
+         * serialized, and the reader keeps a reference to the stream). */
+        ChunkReader streamChunkReader( IInStream* in_stream );
+
+        /* Returns a ChunkReader copying the data from the input buffer, which must outlive the reader. */
+        ChunkReader bufferChunkReader( const std::vector< byte_t >& in_buffer );
+
+        /* A function returning a stream over the range [begin, end) of the input data, where begin and end are its
+         * first and second arguments. */
+        typedef std::function< CMyComPtr< IInStream >( uint64_t, uint64_t ) > RangeStreamOpener;
+
+        /* Returns a RangeStreamOpener reading from the given file, which can be called concurrently (each stream opens
+         * the file on its own). */
+        RangeStreamOpener fileRangeOpener( const wstring& in_file );
+
+        /* Returns a RangeStreamOpener reading directly from the input buffer (without copies), which must outlive the
+         * opener and the streams it returns. */
+        RangeStreamOpener bufferRangeOpener( const std::vector< byte_t >& in_buffer );
+
+        void writeData( ISequentialOutStream* out_stream, const byte_t* data, size_t size );
+
+        void writeBuffer( ISequentialOutStream* out_stream, const std::vector< byte_t >& buffer );
+
+        /* Creates the output archive handler and applies the settings of the creator to it; if threads_count is not 0,
+         * it overrides the number of threads used by the handler. */
+        CMyComPtr< IOutArchive > initOutArchive( const Bit7zLibrary& lib, const BitArchiveCreator& creator,
+                                                 uint32_t threads_count = 0 );
+
+        CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
+                                             const wstring& in_file, const BitArchiveOpener& opener,
+                                             bool sequential_access = false );
+
+        CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
+                                             const std::vector< byte_t >& in_buffer, const BitArchiveOpener& opener );
 
         CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
-                                             const wstring& in_file, const BitArchiveOpener& opener );
+                                             IInStream* in_stream, const BitArchiveOpener& opener );
+
+        void setDecoderProperties( IInArchive* in_archive, const BitArchiveOpener& opener );
+
+        uint32_t itemsCount( IInArchive* in_archive );
+
+        void checkIndices( IInArchive* in_archive, const std::vector< uint32_t >& indices );
+
+        /* Sorts (ascending) and deduplicates the given indices, as required by IInArchive::Extract.
+         * Throws a BitException if any index is out of range. */
+        void orderIndices( IInArchive* in_archive, std::vector< uint32_t >& indices );
+
+        std::vector< uint32_t > matchingIndices( IInArchive* in_archive, const wstring& item_filter );
+
+        std::vector< uint32_t > matchingIndices( IInArchive* in_archive, const std::vector< wstring >& item_filters,
+                                                 bool case_sensitive );
+
+        std::vector< uint32_t > matchingIndices( IInArchive* in_archive, const ItemPredicate& predicate );
+
+        void extractToFileSystem( IInArchive* in_archive, const BitArchiveOpener& opener, const wstring& in_file,
+                                  const wstring& out_dir, std::vector< uint32_t > indices );
+
+        void extractToBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                              std::vector< byte_t >& out_buffer, uint32_t index );
+
+        void extractToBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                              BitChunkedBuffer& out_buffer, uint32_t index );
+
+        void extractToItemsBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                                   std::vector< uint32_t > indices, BitItemsBuffer& out_items );
+
+        void extractToSinks( IInArchive* in_archive, const BitArchiveOpener& opener,
+                             const SinkFactory& sink_factory, std::vector< uint32_t > indices );
+
+        void testArchive( IInArchive* in_archive, const BitArchiveOpener& opener, const wstring& in_file );
 
         HRESULT IsArchiveItemProp( IInArchive* archive, UInt32 index, PROPID propID, bool& result );
 
         HRESULT IsArchiveItemFolder( IInArchive* archive, UInt32 index, bool& result );
+
+        uint32_t hardwareThreads();
+
+        /* Runs task( task_index, worker_index ) for every task_index in [0, tasks_count) on at most threads_count
+         * worker threads (0 means one thread per hardware thread). If any task throws, the first exception is rethrown
+         * in the calling thread after all the workers have terminated. */
+        void parallelFor( uint32_t tasks_count, uint32_t threads_count,
+                          const std::function< void( uint32_t, uint32_t ) >& task );
+
+        /* Splits the in_size bytes of the input into chunks of creator.chunkSize() bytes, compresses each chunk into an
+         * independent member (e.g. a GZip or BZip2 stream) on its own output archive, and writes the members to
+         * out_stream in the same order of the chunks. The chunks are compressed in parallel by
+         * creator.effectiveThreadsCount() threads; read_chunk( offset, chunk ) must fill the (already sized) chunk with
+         * the input data at the given offset, and it may be called concurrently. The callbacks of the creator are
+         * called concurrently too, by the handler of each chunk, with the progress of that chunk only. */
+        void compressMembers( const Bit7zLibrary& lib, const BitArchiveCreator& creator, uint64_t in_size,
+                              const ChunkReader& read_chunk, const wstring& item_name, ISequentialOutStream* out_stream );
+
+        /* Scans the in_size bytes of a GZip or BZip2 input for the signatures of its members (i.e. of the concatenated
+         * streams), returning their offsets (the first one is always 0). The offsets are only candidates, since
+         * a signature may also appear by chance inside the compressed data. */
+        std::vector< uint64_t > findMembers( const BitInFormat& format, uint64_t in_size, const ChunkReader& read_chunk );
+
+        /* Decompresses the members of a GZip or BZip2 input in parallel (each one on its own archive handler over a
+         * stream returned by open_range, while read_chunk is used to find the members), and writes their content to
+         * out_stream in the same order of the members. The member being written is decompressed directly to
+         * out_stream, while the outputs of the members following it are buffered until their turn comes.
+         * The members ending at a false candidate offset fail to decompress: in such case, the rest of the input
+         * (from the start of the failed member) is decompressed sequentially in a single pass. */
+        void extractMembers( const Bit7zLibrary& lib, const BitInFormat& format, const BitArchiveOpener& opener,
+                             uint64_t in_size, const ChunkReader& read_chunk, const RangeStreamOpener& open_range,
+                             uint32_t threads_count, ISequentialOutStream* out_stream );
     }
 }
 
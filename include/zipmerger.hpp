@@ -0,0 +1,60 @@
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#ifndef ZIPMERGER_HPP
+#define ZIPMERGER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "7zip/IStream.h"
+#include "Common/MyCom.h"
+
+#include "../include/bittypes.hpp"
+
+namespace bit7z {
+    using std::wstring;
+    using std::vector;
+
+    /* Concatenates the entries of several ZIP archives into a single output archive, in the order in which the
+     * archives are appended: the local headers and the data of the entries are copied as they are, while their
+     * central directory records are rebased on the new offsets (switching to ZIP64 fields when needed).
+     * The central directory of the output archive is written by finalize(). */
+    class ZipMerger {
+        public:
+            explicit ZipMerger( ISequentialOutStream* out_stream );
+
+            void append( const wstring& in_archive );
+
+            void finalize();
+
+        private:
+            CMyComPtr< ISequentialOutStream > mOutStream;
+            uint64_t mOffset;
+            uint64_t mEntriesCount;
+            vector< byte_t > mCentralDirectory;
+
+            void appendEntry( const byte_t* record, size_t record_size, uint64_t base_offset );
+
+            //non-copyable
+            ZipMerger( const ZipMerger& other );
+            ZipMerger& operator=( const ZipMerger& other );
+    };
+}
+#endif // ZIPMERGER_HPP
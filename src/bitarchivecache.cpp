@@ -0,0 +1,269 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/bitarchivecache.hpp"
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <Windows.h>
+
+#include "../include/bitexception.hpp"
+#include "../include/fsutil.hpp"
+
+using namespace bit7z;
+using namespace bit7z::filesystem;
+
+using std::list;
+using std::multimap;
+using std::mutex;
+using std::lock_guard;
+using std::unique_ptr;
+using std::weak_ptr;
+using std::vector;
+
+/* Rough estimate of the memory used by the 7z handlers for keeping the properties (path, sizes, times, attributes...)
+ * of an item of an opened archive. */
+const uint64_t kEstimatedItemMemory = 512;
+
+namespace {
+    struct CacheKey {
+        uint32_t volumeSerialNumber;
+        uint64_t fileIndex;
+        uint64_t size;
+        uint64_t lastWriteTime;
+        int format;
+        wstring password;
+
+        bool operator<( const CacheKey& other ) const {
+            return std::tie( volumeSerialNumber, fileIndex, size, lastWriteTime, format, password ) <
+                   std::tie( other.volumeSerialNumber, other.fileIndex, other.size, other.lastWriteTime, other.format,
+                             other.password );
+        }
+    };
+
+    struct CacheEntry {
+        CacheKey key;
+        unique_ptr< BitArchiveReader > reader;
+        uint64_t memory;
+    };
+
+    CacheKey makeKey( const wstring& in_file, const BitInFormat& format, const wstring& password ) {
+        /* The file is identified by its volume and its index in the volume, rather than by its path: different paths
+         * of the same file (e.g. differing in case, 8.3 short names, or through links) share the same cache entries. */
+        HANDLE file_handle = CreateFile( in_file.c_str(), FILE_READ_ATTRIBUTES,
+                                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                         FILE_ATTRIBUTE_NORMAL, nullptr );
+        if ( file_handle == INVALID_HANDLE_VALUE ) {
+            throw BitException( L"Cannot open archive '" + in_file + L"'" );
+        }
+        BY_HANDLE_FILE_INFORMATION file_data;
+        BOOL got_info = GetFileInformationByHandle( file_handle, &file_data );
+        CloseHandle( file_handle );
+        if ( !got_info || ( file_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 ) {
+            throw BitException( L"Cannot open archive '" + in_file + L"'" );
+        }
+        CacheKey key;
+        key.volumeSerialNumber = file_data.dwVolumeSerialNumber;
+        key.fileIndex = ( static_cast< uint64_t >( file_data.nFileIndexHigh ) << 32 ) | file_data.nFileIndexLow;
+        key.size = ( static_cast< uint64_t >( file_data.nFileSizeHigh ) << 32 ) | file_data.nFileSizeLow;
+        key.lastWriteTime = ( static_cast< uint64_t >( file_data.ftLastWriteTime.dwHighDateTime ) << 32 ) |
+                            file_data.ftLastWriteTime.dwLowDateTime;
+        key.format = format.value();
+        key.password = password;
+        return key;
+    }
+
+    uint64_t estimateMemory( const BitArchiveReader& reader ) {
+        uint64_t memory = static_cast< uint64_t >( reader.itemsCount() ) * kEstimatedItemMemory;
+        BitPropVariant headers_size = reader.getArchiveProperty( BitProperty::HeadersSize );
+        if ( headers_size.isUInt64() ) {
+            memory += headers_size.getUInt64();
+        }
+        return memory;
+    }
+}
+
+struct BitArchiveCache::State {
+    mutex mMutex;
+    list< CacheEntry > mEntries; // from the most to the least recently used
+    multimap< CacheKey, list< CacheEntry >::iterator > mIndex;
+    uint32_t mMaxHandles;
+    uint64_t mMaxMemory;
+    uint64_t mMemoryUsage;
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mEvictions;
+
+    State( uint32_t max_handles, uint64_t max_memory )
+        : mMaxHandles( max_handles ), mMaxMemory( max_memory ), mMemoryUsage( 0 ), mHits( 0 ), mMisses( 0 ),
+          mEvictions( 0 ) {}
+
+    // Note: the caller must hold the lock on mMutex
+    void erase( multimap< CacheKey, list< CacheEntry >::iterator >::iterator index_it,
+                vector< unique_ptr< BitArchiveReader > >& evicted ) {
+        list< CacheEntry >::iterator entry = index_it->second;
+        evicted.push_back( std::move( entry->reader ) );
+        mMemoryUsage -= entry->memory;
+        mEntries.erase( entry );
+        mIndex.erase( index_it );
+    }
+
+    // Note: the caller must hold the lock on mMutex
+    void shrink( vector< unique_ptr< BitArchiveReader > >& evicted ) {
+        while ( !mEntries.empty() &&
+                ( mEntries.size() > mMaxHandles || ( mMaxMemory > 0 && mMemoryUsage > mMaxMemory ) ) ) {
+            auto range = mIndex.equal_range( mEntries.back().key );
+            for ( auto it = range.first; it != range.second; ++it ) {
+                if ( it->second == std::prev( mEntries.end() ) ) {
+                    erase( it, evicted );
+                    ++mEvictions;
+                    break;
+                }
+            }
+        }
+    }
+
+    void release( BitArchiveReader* reader, const CacheKey& key, uint64_t memory ) {
+        // Evicted readers are closed outside the lock, since closing an archive may take some time
+        vector< unique_ptr< BitArchiveReader > > evicted;
+        try {
+            // The entry is allocated before touching the cache: if anything fails, the reader is simply closed
+            list< CacheEntry > node( 1 );
+            node.front().key = key;
+            node.front().memory = memory;
+            node.front().reader.reset( reader );
+            reader = nullptr;
+
+            // Cleaning up the reader from the changes made by its last user
+            BitArchiveReader& cached_reader = *node.front().reader;
+            cached_reader.setTotalCallback( TotalCallback() );
+            cached_reader.setProgressCallback( ProgressCallback() );
+            cached_reader.setRatioCallback( RatioCallback() );
+            cached_reader.setFileCallback( FileCallback() );
+            cached_reader.setPasswordCallback( PasswordCallback() );
+            cached_reader.setPassword( key.password );
+            cached_reader.setThreadsCount( 0 );
+            cached_reader.setMemoryUsageLimit( 0 );
+            cached_reader.setInputMode( BitInputMode::FileStream );
+            cached_reader.setFreeSpaceCheck( false );
+
+            lock_guard< mutex > lock( mMutex );
+            mIndex.insert( std::make_pair( key, node.begin() ) );
+            mEntries.splice( mEntries.begin(), node ); // no-throw (and the iterator in the index remains valid)
+            mMemoryUsage += memory;
+            shrink( evicted );
+        } catch ( ... ) {
+            delete reader; // the reader could not be cached (e.g. out of memory)
+        }
+    }
+};
+
+BitArchiveCache::BitArchiveCache( const Bit7zLibrary& lib, uint32_t max_handles, uint64_t max_memory )
+    : mLibrary( lib ), mState( std::make_shared< State >( max_handles, max_memory ) ) {}
+
+BitArchiveCache::~BitArchiveCache() {
+    clear();
+}
+
+shared_ptr< BitArchiveReader > BitArchiveCache::open( const wstring& in_file, const BitInFormat& format,
+                                                      const wstring& password ) {
+    CacheKey key = makeKey( in_file, format, password );
+
+    unique_ptr< BitArchiveReader > reader;
+    uint64_t memory = 0;
+    vector< unique_ptr< BitArchiveReader > > evicted;
+    {
+        lock_guard< mutex > lock( mState->mMutex );
+        auto index_it = mState->mIndex.find( key );
+        if ( index_it != mState->mIndex.end() ) {
+            memory = index_it->second->memory;
+            reader = std::move( index_it->second->reader );
+            mState->mMemoryUsage -= memory;
+            mState->mEntries.erase( index_it->second );
+            mState->mIndex.erase( index_it );
+            ++mState->mHits;
+        } else {
+            ++mState->mMisses;
+            // Discarding the stale entries of the same archive file (i.e. with a different size or modification time)
+            CacheKey file_key;
+            file_key.volumeSerialNumber = key.volumeSerialNumber;
+            file_key.fileIndex = key.fileIndex;
+            file_key.size = 0;
+            file_key.lastWriteTime = 0;
+            file_key.format = 0;
+            for ( auto it = mState->mIndex.lower_bound( file_key );
+                    it != mState->mIndex.end() && it->first.volumeSerialNumber == key.volumeSerialNumber &&
+                    it->first.fileIndex == key.fileIndex; ) {
+                auto current = it++;
+                if ( current->first.size != key.size || current->first.lastWriteTime != key.lastWriteTime ) {
+                    mState->erase( current, evicted );
+                    ++mState->mEvictions;
+                }
+            }
+        }
+    }
+
+    if ( !reader ) { // cache miss: the archive is opened outside the lock, so that other requests are not blocked
+        reader.reset( new BitArchiveReader( mLibrary, fsutil::absolute_path( in_file ), format, password ) );
+        memory = estimateMemory( *reader );
+    }
+
+    /* Note: if the creation of the shared pointer fails, the deleter is called, hence the reader is given back
+     * to the cache also in that case. */
+    weak_ptr< State > state = mState;
+    return shared_ptr< BitArchiveReader >( reader.release(), [ state, key, memory ]( BitArchiveReader* leased ) {
+        shared_ptr< State > cache_state = state.lock();
+        if ( cache_state ) {
+            cache_state->release( leased, key, memory );
+        } else { // the cache has been destroyed
+            delete leased;
+        }
+    } );
+}
+
+void BitArchiveCache::clear() {
+    vector< unique_ptr< BitArchiveReader > > evicted;
+    {
+        lock_guard< mutex > lock( mState->mMutex );
+        for ( CacheEntry& entry : mState->mEntries ) {
+            evicted.push_back( std::move( entry.reader ) );
+        }
+        mState->mEvictions += mState->mEntries.size();
+        mState->mEntries.clear();
+        mState->mIndex.clear();
+        mState->mMemoryUsage = 0;
+    }
+}
+
+BitArchiveCacheStats BitArchiveCache::stats() const {
+    lock_guard< mutex > lock( mState->mMutex );
+    BitArchiveCacheStats stats;
+    stats.hits = mState->mHits;
+    stats.misses = mState->mMisses;
+    stats.evictions = mState->mEvictions;
+    stats.handlesCount = static_cast< uint32_t >( mState->mEntries.size() );
+    stats.memoryUsage = mState->mMemoryUsage;
+    return stats;
+}
@@ -0,0 +1,262 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/bitarchivecatalog.hpp"
+
+#include <algorithm>
+
+#include "7zip/Archive/IArchive.h"
+
+#include "../include/bitarchiveinfo.hpp"
+#include "../include/bitexception.hpp"
+
+using namespace bit7z;
+
+namespace {
+    enum CatalogFlags : uint16_t {
+        kHasPath      = 1 << 0,
+        kHasSize      = 1 << 1,
+        kHasPackSize  = 1 << 2,
+        kHasMTime     = 1 << 3,
+        kHasAttrib    = 1 << 4,
+        kHasCRC       = 1 << 5,
+        kHasIsDir     = 1 << 6,
+        kIsDir        = 1 << 7,
+        kHasEncrypted = 1 << 8,
+        kIsEncrypted  = 1 << 9
+    };
+
+    inline uint64_t valueKey( uint32_t index, BitProperty property ) {
+        return ( static_cast< uint64_t >( index ) << 32 ) | static_cast< uint32_t >( property );
+    }
+}
+
+BitArchiveCatalog::BitArchiveCatalog( const BitArchiveInfo& archive, IInArchive* in_archive )
+    : mOtherProperties( archive.supportedItemProperties() ), mInArchive( in_archive ) {
+    mInArchive->AddRef();
+    mOtherProperties.erase( std::remove_if( mOtherProperties.begin(), mOtherProperties.end(), &isStored ),
+                            mOtherProperties.end() );
+
+    uint32_t items_count = archive.itemsCount();
+    mPathsOffsets.reserve( items_count + 1 );
+    mSizes.resize( items_count, 0 );
+    mPackSizes.resize( items_count, 0 );
+    mModifiedTimes.resize( items_count, FILETIME() );
+    mAttributes.resize( items_count, 0 );
+    mCRCs.resize( items_count, 0 );
+    mFlags.resize( items_count, 0 );
+
+    mPathsOffsets.push_back( 0 );
+    for ( uint32_t i = 0; i < items_count; ++i ) {
+        uint16_t& flags = mFlags[ i ];
+
+        BitPropVariant value = archive.getItemProperty( i, BitProperty::Path );
+        if ( value.isString() ) {
+            const wchar_t* path = value.getStringData();
+            mPaths.insert( mPaths.end(), path, path + value.getStringLength() );
+            flags |= kHasPath;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::Path ) ] = value;
+        }
+        mPathsOffsets.push_back( mPaths.size() );
+
+        /* Values are stored in the columns only if they have the expected type, so that getProperty returns exactly
+         * the same BitPropVariant returned by the archive handler. */
+        value = archive.getItemProperty( i, BitProperty::Size );
+        if ( value.type() == BitPropVariantType::UInt64 ) {
+            mSizes[ i ] = value.getUInt64();
+            flags |= kHasSize;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::Size ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::PackSize );
+        if ( value.type() == BitPropVariantType::UInt64 ) {
+            mPackSizes[ i ] = value.getUInt64();
+            flags |= kHasPackSize;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::PackSize ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::MTime );
+        if ( value.isFiletime() ) {
+            mModifiedTimes[ i ] = value.getFiletime();
+            flags |= kHasMTime;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::MTime ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::Attrib );
+        if ( value.type() == BitPropVariantType::UInt32 ) {
+            mAttributes[ i ] = value.getUInt32();
+            flags |= kHasAttrib;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::Attrib ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::CRC );
+        if ( value.type() == BitPropVariantType::UInt32 ) {
+            mCRCs[ i ] = value.getUInt32();
+            flags |= kHasCRC;
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::CRC ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::IsDir );
+        if ( value.isBool() ) {
+            flags |= kHasIsDir | ( value.getBool() ? kIsDir : 0 );
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::IsDir ) ] = value;
+        }
+
+        value = archive.getItemProperty( i, BitProperty::Encrypted );
+        if ( value.isBool() ) {
+            flags |= kHasEncrypted | ( value.getBool() ? kIsEncrypted : 0 );
+        } else if ( !value.isEmpty() ) {
+            mOtherValues[ valueKey( i, BitProperty::Encrypted ) ] = value;
+        }
+    }
+    mPaths.shrink_to_fit();
+}
+
+BitArchiveCatalog::~BitArchiveCatalog() {
+    mInArchive->Release();
+}
+
+uint32_t BitArchiveCatalog::itemsCount() const {
+    return static_cast< uint32_t >( mFlags.size() );
+}
+
+wstring BitArchiveCatalog::path( uint32_t index ) const {
+    checkIndex( index );
+    if ( mPathsOffsets[ index + 1 ] == mPathsOffsets[ index ] ) {
+        return L"";
+    }
+    return wstring( &mPaths[ mPathsOffsets[ index ] ], mPathsOffsets[ index + 1 ] - mPathsOffsets[ index ] );
+}
+
+bool BitArchiveCatalog::isDir( uint32_t index ) const {
+    checkIndex( index );
+    return ( mFlags[ index ] & kIsDir ) != 0;
+}
+
+bool BitArchiveCatalog::isEncrypted( uint32_t index ) const {
+    checkIndex( index );
+    return ( mFlags[ index ] & kIsEncrypted ) != 0;
+}
+
+uint64_t BitArchiveCatalog::size( uint32_t index ) const {
+    checkIndex( index );
+    return mSizes[ index ];
+}
+
+uint64_t BitArchiveCatalog::packSize( uint32_t index ) const {
+    checkIndex( index );
+    return mPackSizes[ index ];
+}
+
+BitPropVariant BitArchiveCatalog::getProperty( uint32_t index, BitProperty property ) const {
+    checkIndex( index );
+    uint16_t flags = mFlags[ index ];
+    switch ( property ) {
+        case BitProperty::Path:
+            if ( flags & kHasPath ) {
+                return BitPropVariant( path( index ) );
+            }
+            break;
+        case BitProperty::Size:
+            if ( flags & kHasSize ) {
+                return BitPropVariant( mSizes[ index ] );
+            }
+            break;
+        case BitProperty::PackSize:
+            if ( flags & kHasPackSize ) {
+                return BitPropVariant( mPackSizes[ index ] );
+            }
+            break;
+        case BitProperty::MTime:
+            if ( flags & kHasMTime ) {
+                return BitPropVariant( mModifiedTimes[ index ] );
+            }
+            break;
+        case BitProperty::Attrib:
+            if ( flags & kHasAttrib ) {
+                return BitPropVariant( mAttributes[ index ] );
+            }
+            break;
+        case BitProperty::CRC:
+            if ( flags & kHasCRC ) {
+                return BitPropVariant( mCRCs[ index ] );
+            }
+            break;
+        case BitProperty::IsDir:
+            if ( flags & kHasIsDir ) {
+                return BitPropVariant( ( flags & kIsDir ) != 0 );
+            }
+            break;
+        case BitProperty::Encrypted:
+            if ( flags & kHasEncrypted ) {
+                return BitPropVariant( ( flags & kIsEncrypted ) != 0 );
+            }
+            break;
+        default: { // not stored in the catalog: it is retrieved from the archive
+            BitPropVariant propvar;
+            std::lock_guard< std::mutex > lock( mArchiveMutex );
+            if ( mInArchive->GetProperty( index, static_cast< PROPID >( property ), &propvar ) != S_OK ) {
+                throw BitException( "Could not retrieve property for item at index " + std::to_string( index ) );
+            }
+            return propvar;
+        }
+    }
+    auto value_it = mOtherValues.find( valueKey( index, property ) );
+    return value_it != mOtherValues.end() ? value_it->second : BitPropVariant();
+}
+
+const vector< BitProperty >& BitArchiveCatalog::otherProperties() const {
+    return mOtherProperties;
+}
+
+BitArchiveItem BitArchiveCatalog::item( uint32_t index ) const {
+    checkIndex( index );
+    return BitArchiveItem( index, shared_from_this() );
+}
+
+bool BitArchiveCatalog::isStored( BitProperty property ) {
+    switch ( property ) {
+        case BitProperty::Path:
+        case BitProperty::Size:
+        case BitProperty::PackSize:
+        case BitProperty::MTime:
+        case BitProperty::Attrib:
+        case BitProperty::CRC:
+        case BitProperty::IsDir:
+        case BitProperty::Encrypted:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void BitArchiveCatalog::checkIndex( uint32_t index ) const {
+    if ( index >= mFlags.size() ) {
+        throw BitException( "Index " + std::to_string( index ) + " is out of range" );
+    }
+}
@@ -21,20 +21,104 @@
 
 #include "../include/bitarchivecreator.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "../include/bitexception.hpp"
+#include "../include/util.hpp"
+
 using std::wstring;
+using std::to_wstring;
 using namespace bit7z;
 
+namespace {
+    BitCompressionMethod defaultMethod( const BitInOutFormat& format ) {
+        if ( format == BitFormat::SevenZip || format == BitFormat::Xz ) {
+            return BitCompressionMethod::Lzma2;
+        }
+        if ( format == BitFormat::Zip || format == BitFormat::GZip ) {
+            return BitCompressionMethod::Deflate;
+        }
+        if ( format == BitFormat::BZip2 ) {
+            return BitCompressionMethod::BZip2;
+        }
+        return BitCompressionMethod::Copy; // e.g. Tar and Wim
+    }
+
+    bool isMethodSupported( const BitInOutFormat& format, BitCompressionMethod method ) {
+        if ( format == BitFormat::SevenZip ) {
+            return true;
+        }
+        if ( format == BitFormat::Zip ) {
+            return method != BitCompressionMethod::Lzma2;
+        }
+        return method == defaultMethod( format );
+    }
+
+    const wchar_t* methodName( BitCompressionMethod method ) {
+        switch ( method ) {
+            case BitCompressionMethod::Copy:
+                return L"Copy";
+            case BitCompressionMethod::Deflate:
+                return L"Deflate";
+            case BitCompressionMethod::Deflate64:
+                return L"Deflate64";
+            case BitCompressionMethod::BZip2:
+                return L"BZip2";
+            case BitCompressionMethod::Lzma:
+                return L"LZMA";
+            case BitCompressionMethod::Lzma2:
+                return L"LZMA2";
+            case BitCompressionMethod::Ppmd:
+            default:
+                return L"PPMd";
+        }
+    }
+
+    const wchar_t* matchFinderName( BitMatchFinder match_finder ) {
+        switch ( match_finder ) {
+            case BitMatchFinder::BT2:
+                return L"BT2";
+            case BitMatchFinder::BT3:
+                return L"BT3";
+            case BitMatchFinder::BT4:
+                return L"BT4";
+            case BitMatchFinder::HC4:
+            default:
+                return L"HC4";
+        }
+    }
+
+    std::string methodNameA( BitCompressionMethod method ) {
+        wstring name = methodName( method );
+        return std::string( name.begin(), name.end() );
+    }
+}
+
 BitArchiveCreator::BitArchiveCreator( const Bit7zLibrary& lib, const BitInOutFormat& format ) :
     BitArchiveHandler( lib ),
     mFormat( format ),
     mCompressionLevel( NORMAL ),
+    mCompressionMethod( defaultMethod( format ) ),
+    mDictionarySize( 0 ),
+    mWordSize( 0 ),
+    mMatchFinder( BitMatchFinder::BT4 ),
+    mMatchFinderSet( false ),
     mCryptHeaders( false ),
     mSolidMode( false ),
-    mVolumeSize( 0 ) {}
+    mVolumeSize( 0 ),
+    mSolidBlockSize( 0 ),
+    mSolidBlockFilesCount( 0 ),
+    mThreadsCount( 0 ),
+    mThreadsFraction( 1.0 ),
+    mChunkSize( 0 ),
+    mReadAheadFilesCount( 0 ),
+    mReadAheadMemoryLimit( 0 ),
+    mSourceInputMode( BitInputMode::FileStream ) {}
 
 BitArchiveCreator::~BitArchiveCreator() {}
 
-const BitInOutFormat& BitArchiveCreator::compressionFormat() {
+const BitInOutFormat& BitArchiveCreator::compressionFormat() const {
     return mFormat;
 }
 
@@ -46,6 +130,26 @@ BitCompressionLevel BitArchiveCreator::compressionLevel() const {
     return mCompressionLevel;
 }
 
+BitCompressionMethod BitArchiveCreator::compressionMethod() const {
+    return mCompressionMethod;
+}
+
+uint32_t BitArchiveCreator::dictionarySize() const {
+    return mDictionarySize;
+}
+
+uint32_t BitArchiveCreator::wordSize() const {
+    return mWordSize;
+}
+
+uint64_t BitArchiveCreator::solidBlockSize() const {
+    return mSolidBlockSize;
+}
+
+uint32_t BitArchiveCreator::solidBlockFilesCount() const {
+    return mSolidBlockFilesCount;
+}
+
 bool BitArchiveCreator::solidMode() const {
     return mSolidMode;
 }
@@ -54,6 +158,38 @@ uint64_t BitArchiveCreator::volumeSize() const {
     return mVolumeSize;
 }
 
+uint64_t BitArchiveCreator::chunkSize() const {
+    return mChunkSize;
+}
+
+uint32_t BitArchiveCreator::readAheadFilesCount() const {
+    return mReadAheadFilesCount;
+}
+
+uint64_t BitArchiveCreator::readAheadMemoryLimit() const {
+    return mReadAheadMemoryLimit;
+}
+
+BitInputMode BitArchiveCreator::sourceInputMode() const {
+    return mSourceInputMode;
+}
+
+uint32_t BitArchiveCreator::threadsCount() const {
+    return mThreadsCount;
+}
+
+uint32_t BitArchiveCreator::effectiveThreadsCount() const {
+    if ( !mFormat.hasFeature( MULTITHREADING ) && mChunkSize == 0 ) {
+        return 1;
+    }
+    if ( mThreadsCount > 0 ) {
+        return mThreadsCount;
+    }
+    uint32_t available_threads = util::hardwareThreads();
+    auto threads = static_cast< uint32_t >( std::lround( available_threads * mThreadsFraction ) );
+    return std::max( 1u, std::min( threads, available_threads ) );
+}
+
 void BitArchiveCreator::setPassword( const wstring &password ) {
     setPassword( password, mCryptHeaders );
 }
@@ -67,6 +203,50 @@ void BitArchiveCreator::setCompressionLevel( BitCompressionLevel compression_lev
     mCompressionLevel = compression_level;
 }
 
+void BitArchiveCreator::setCompressionMethod( BitCompressionMethod method ) {
+    if ( !isMethodSupported( mFormat, method ) ) {
+        throw BitException( "Compression method " + methodNameA( method ) + " is not supported by the output format" );
+    }
+    mCompressionMethod = method;
+}
+
+void BitArchiveCreator::setDictionarySize( uint32_t dictionary_size ) {
+    mDictionarySize = dictionary_size;
+}
+
+void BitArchiveCreator::setWordSize( uint32_t word_size ) {
+    mWordSize = word_size;
+}
+
+void BitArchiveCreator::setMatchFinder( BitMatchFinder match_finder ) {
+    mMatchFinder = match_finder;
+    mMatchFinderSet = true;
+}
+
+void BitArchiveCreator::setSolidBlockSize( uint64_t block_size, uint32_t files_count ) {
+    if ( !mFormat.hasFeature( SOLID_ARCHIVE ) ) {
+        throw BitException( "Solid blocks are not supported by the output format" );
+    }
+    mSolidBlockSize = block_size;
+    mSolidBlockFilesCount = files_count;
+}
+
+void BitArchiveCreator::setChunkSize( uint64_t chunk_size ) {
+    if ( chunk_size > 0 && !mFormat.hasFeature( MULTIPLE_MEMBERS ) ) {
+        throw BitException( "Multiple members are not supported by the output format" );
+    }
+    mChunkSize = chunk_size;
+}
+
+void BitArchiveCreator::setReadAhead( uint32_t files_count, uint64_t memory_limit ) {
+    mReadAheadFilesCount = files_count;
+    mReadAheadMemoryLimit = memory_limit;
+}
+
+void BitArchiveCreator::setSourceInputMode( BitInputMode input_mode ) {
+    mSourceInputMode = input_mode;
+}
+
 void BitArchiveCreator::setSolidMode( bool solid_mode ) {
     mSolidMode = solid_mode;
 }
@@ -74,3 +254,87 @@ void BitArchiveCreator::setSolidMode( bool solid_mode ) {
 void BitArchiveCreator::setVolumeSize( uint64_t size ) {
     mVolumeSize = size;
 }
+
+void BitArchiveCreator::setThreadsCount( uint32_t threads_count ) {
+    mThreadsCount = threads_count;
+    mThreadsFraction = 1.0;
+}
+
+void BitArchiveCreator::setThreadsFraction( double fraction ) {
+    if ( !( fraction > 0.0 && fraction <= 1.0 ) ) {
+        throw BitException( "Invalid threads fraction (it must be in the interval (0, 1])" );
+    }
+    mThreadsCount = 0;
+    mThreadsFraction = fraction;
+}
+
+void BitArchiveCreator::archiveProperties( vector< const wchar_t* >& names, vector< BitPropVariant >& values ) const {
+    if ( mCryptHeaders && mFormat.hasFeature( HEADER_ENCRYPTION ) ) {
+        names.push_back( L"he" );
+        values.emplace_back( true );
+    }
+    if ( mFormat.hasFeature( COMPRESSION_LEVEL ) ) {
+        names.push_back( L"x" );
+        values.emplace_back( static_cast< uint32_t >( mCompressionLevel ) );
+    }
+    if ( mFormat.hasFeature( SOLID_ARCHIVE ) ) {
+        names.push_back( L"s" );
+        if ( mSolidMode && ( mSolidBlockSize > 0 || mSolidBlockFilesCount > 0 ) ) {
+            wstring solid_settings;
+            if ( mSolidBlockFilesCount > 0 ) {
+                solid_settings += to_wstring( mSolidBlockFilesCount ) + L"f";
+            }
+            if ( mSolidBlockSize > 0 ) {
+                solid_settings += to_wstring( mSolidBlockSize ) + L"b";
+            }
+            values.emplace_back( solid_settings );
+        } else {
+            values.emplace_back( mSolidMode );
+        }
+    }
+    if ( mFormat.hasFeature( MULTITHREADING ) ) {
+        // when compressing in chunks, the threads are used for compressing different members at the same time
+        names.push_back( L"mt" );
+        values.emplace_back( mChunkSize > 0 ? 1u : effectiveThreadsCount() );
+    }
+
+    /* The method is set only if it is not the default one of the format, so that the handler can still choose it
+     * according to the compression level (e.g. the Copy method when the level is NONE). */
+    if ( mCompressionMethod != defaultMethod( mFormat ) ) {
+        names.push_back( mFormat == BitFormat::SevenZip ? L"0" : L"m" );
+        values.emplace_back( methodName( mCompressionMethod ) );
+    }
+
+    bool is_lzma = mCompressionMethod == BitCompressionMethod::Lzma || mCompressionMethod == BitCompressionMethod::Lzma2;
+    if ( mDictionarySize > 0 ) {
+        if ( mCompressionMethod == BitCompressionMethod::Ppmd ) {
+            names.push_back( L"mem" );
+        } else if ( is_lzma || mCompressionMethod == BitCompressionMethod::BZip2 ) {
+            names.push_back( L"d" );
+        } else {
+            throw BitException( "Dictionary size is not supported by compression method " +
+                                methodNameA( mCompressionMethod ) );
+        }
+        values.emplace_back( mDictionarySize );
+    }
+    if ( mWordSize > 0 ) {
+        if ( mCompressionMethod == BitCompressionMethod::Ppmd ) {
+            names.push_back( L"o" );
+        } else if ( is_lzma || mCompressionMethod == BitCompressionMethod::Deflate ||
+                    mCompressionMethod == BitCompressionMethod::Deflate64 ) {
+            names.push_back( L"fb" );
+        } else {
+            throw BitException( "Word size is not supported by compression method " +
+                                methodNameA( mCompressionMethod ) );
+        }
+        values.emplace_back( mWordSize );
+    }
+    if ( mMatchFinderSet ) {
+        if ( !is_lzma ) {
+            throw BitException( "Match finder is not supported by compression method " +
+                                methodNameA( mCompressionMethod ) );
+        }
+        names.push_back( L"mf" );
+        values.emplace_back( matchFinderName( mMatchFinder ) );
+    }
+}
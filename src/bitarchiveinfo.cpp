@@ -21,6 +21,9 @@
 
 #include "../include/bitarchiveinfo.hpp"
 
+#include <algorithm>
+#include <set>
+
 #include "7zip/PropID.h"
 
 #include "../include/bitexception.hpp"
@@ -29,11 +32,22 @@
 using namespace bit7z;
 using namespace bit7z::util;
 
-BitArchiveInfo::BitArchiveInfo( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format )
-    : BitArchiveOpener( lib, format ) {
+using std::set;
+
+BitArchiveInfo::BitArchiveInfo( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format,
+                                const wstring& password ) : BitArchiveOpener( lib, format ), mInFile( in_file ),
+    mStats(), mStatsComputed( false ) {
+    mPassword = password; // the password must be set before opening the archive, since it may be needed to do it!
     mInArchive = openArchive( mLibrary, mFormat, in_file, *this ).Detach();
 }
 
+BitArchiveInfo::BitArchiveInfo( const Bit7zLibrary& lib, const vector< byte_t >& in_buffer, const BitInFormat& format,
+                                const wstring& password ) : BitArchiveOpener( lib, format ), mInFile( L"" ),
+    mStats(), mStatsComputed( false ) {
+    mPassword = password;
+    mInArchive = openArchive( mLibrary, mFormat, in_buffer, *this ).Detach();
+}
+
 BitArchiveInfo::~BitArchiveInfo() {
     if ( mInArchive ) {
         mInArchive->Release();
@@ -65,71 +79,148 @@ map<BitProperty, BitPropVariant> BitArchiveInfo::archiveProperties() const {
         auto property = static_cast<BitProperty>( i );
         BitPropVariant property_value = getArchiveProperty( property );
         if ( !property_value.isEmpty() ) {
-            result[ property ] = property_value;
+            result[ property ] = std::move( property_value );
         }
     }
     return result;
 }
 
 vector<BitArchiveItem> BitArchiveInfo::items() const {
-    vector<BitArchiveItem> result;
-    for ( uint32_t i = 0; i < itemsCount(); ++i ) {
+    /* The items are views over the catalog shared by all of them, without any property of their own: the properties
+     * not stored in the catalog are retrieved from the archive only on request (see BitArchiveCatalog::getProperty). */
+    shared_ptr< const BitArchiveCatalog > items_catalog = catalog();
+    vector< BitArchiveItem > result;
+    result.reserve( items_catalog->itemsCount() );
+    for ( uint32_t i = 0; i < items_catalog->itemsCount(); ++i ) {
+        result.push_back( BitArchiveItem( i, items_catalog ) );
+    }
+    return result;
+}
+
+shared_ptr< const BitArchiveCatalog > BitArchiveInfo::catalog() const {
+    if ( !mCatalog ) {
+        mCatalog.reset( new BitArchiveCatalog( *this, mInArchive ) );
+    }
+    return mCatalog;
+}
+
+vector< BitArchiveItem > BitArchiveInfo::items( const vector< BitProperty >& properties ) const {
+    vector< BitArchiveItem > result;
+    result.reserve( itemsCount() );
+    forEachItem( [ &result ]( const BitArchiveItem& item ) {
+        result.push_back( item );
+        return true;
+    }, properties );
+    return result;
+}
+
+void BitArchiveInfo::forEachItem( const function< bool( const BitArchiveItem& ) >& visitor,
+                                  const vector< BitProperty >& properties ) const {
+    const vector< BitProperty >& item_properties = properties.empty() ? supportedItemProperties() : properties;
+    uint32_t items_count = itemsCount();
+    for ( uint32_t i = 0; i < items_count; ++i ) {
         BitArchiveItem item( i );
-        for ( uint32_t j = kpidNoProperty; j <= kpidCopyLink; ++j ) {
-            // Yeah, I know, I double cast property (here and in getItemProperty), but the code is easier to read!
-            auto property = static_cast<BitProperty>( j );
+        for ( BitProperty property : item_properties ) {
             BitPropVariant property_value = getItemProperty( i, property );
             if ( !property_value.isEmpty() ) {
-                item.setProperty( property, property_value );
+                item.setProperty( property, std::move( property_value ) );
             }
         }
-        result.push_back( item );
+        if ( !visitor( item ) ) {
+            break;
+        }
+    }
+}
+
+vector< BitProperty > BitArchiveInfo::supportedItemProperties() const {
+    // These properties are needed by BitArchiveItem, but some handlers (e.g. 7z) do not list all of them
+    vector< BitProperty > result = { BitProperty::Path, BitProperty::IsDir, BitProperty::Size, BitProperty::PackSize };
+
+    UInt32 properties_count = 0;
+    if ( mInArchive->GetNumberOfProperties( &properties_count ) != S_OK || properties_count == 0 ) {
+        // the handler does not tell its properties: all of them must be tried
+        result.clear();
+        for ( uint32_t i = kpidNoProperty; i <= kpidCopyLink; ++i ) {
+            result.push_back( static_cast< BitProperty >( i ) );
+        }
+        return result;
+    }
+    for ( UInt32 i = 0; i < properties_count; ++i ) {
+        BSTR name = nullptr;
+        PROPID property_id;
+        VARTYPE var_type;
+        HRESULT res = mInArchive->GetPropertyInfo( i, &name, &property_id, &var_type );
+        if ( name != nullptr ) {
+            SysFreeString( name );
+        }
+        auto property = static_cast< BitProperty >( property_id );
+        if ( res == S_OK && property_id <= kpidCopyLink &&
+                std::find( result.begin(), result.end(), property ) == result.end() ) {
+            result.push_back( property );
+        }
     }
     return result;
 }
 
 uint32_t BitArchiveInfo::itemsCount() const {
-    uint32_t items_count;
-    HRESULT result = mInArchive->GetNumberOfItems( &items_count );
-    if ( result != S_OK ) {
-        throw BitException( "Could not retrieve the number of items in the archive" );
-    }
-    return items_count;
+    return util::itemsCount( mInArchive );
 }
 
 uint32_t BitArchiveInfo::foldersCount() const {
-    uint32_t result = 0;
-    for ( uint32_t i = 0; i < itemsCount(); ++i ) {
-        BitPropVariant prop = getItemProperty( i, BitProperty::IsDir );
-        if ( !prop.isEmpty() && prop.getBool() ) {
-            result += 1;
-        }
-    }
-    return result;
+    return stats().foldersCount;
 }
 
 uint32_t BitArchiveInfo::filesCount() const {
-    return itemsCount() - foldersCount(); //I'm lazy :)
+    return stats().filesCount;
 }
 
 uint64_t BitArchiveInfo::size() const {
-    uint64_t result = 0;
-    for ( uint32_t i = 0; i < itemsCount(); ++i ) {
-        BitPropVariant prop = getItemProperty( i, BitProperty::Size );
-        if ( !prop.isEmpty() ) {
-            result += prop.getUInt64();
-        }
-    }
-    return result;
+    return stats().size;
 }
 
 uint64_t BitArchiveInfo::packSize() const {
-    uint64_t result = 0;
-    for ( uint32_t i = 0; i < itemsCount(); ++i ) {
-        BitPropVariant prop = getItemProperty( i, BitProperty::PackSize );
-        if ( !prop.isEmpty() ) {
-            result += prop.getUInt64();
+    return stats().packSize;
+}
+
+const BitArchiveStats& BitArchiveInfo::stats() const {
+    if ( mStatsComputed ) {
+        return mStats;
+    }
+    BitArchiveStats result = BitArchiveStats();
+    set< uint64_t > blocks;
+    result.itemsCount = itemsCount();
+    for ( uint32_t i = 0; i < result.itemsCount; ++i ) {
+        bool is_dir = false;
+        if ( IsArchiveItemFolder( mInArchive, i, is_dir ) == S_OK && is_dir ) {
+            ++result.foldersCount;
+        }
+
+        BitPropVariant size_prop = getItemProperty( i, BitProperty::Size );
+        if ( !size_prop.isEmpty() ) {
+            uint64_t item_size = size_prop.getUInt64();
+            result.size += item_size;
+            result.maxItemSize = std::max( result.maxItemSize, item_size );
+        }
+
+        BitPropVariant pack_size_prop = getItemProperty( i, BitProperty::PackSize );
+        if ( !pack_size_prop.isEmpty() ) {
+            result.packSize += pack_size_prop.getUInt64();
+        }
+
+        BitPropVariant block_prop = getItemProperty( i, BitProperty::Block );
+        if ( !block_prop.isEmpty() ) {
+            blocks.insert( block_prop.getUInt64() );
+        }
+
+        BitPropVariant encrypted_prop = getItemProperty( i, BitProperty::Encrypted );
+        if ( encrypted_prop.isBool() && encrypted_prop.getBool() ) {
+            ++result.encryptedCount;
         }
     }
-    return result;
+    result.filesCount = result.itemsCount - result.foldersCount;
+    result.solidBlocksCount = static_cast< uint32_t >( blocks.size() );
+
+    mStats = result;
+    mStatsComputed = true;
+    return mStats;
 }
@@ -21,6 +21,7 @@
 
 #include "../include/bitarchiveitem.hpp"
 
+#include "../include/bitarchivecatalog.hpp"
 #include "../include/bitexception.hpp"
 #include "../include/fsutil.hpp"
 
@@ -29,6 +30,9 @@ using namespace bit7z::filesystem;
 
 BitArchiveItem::BitArchiveItem( uint32_t item_index ) : mItemIndex( item_index ) {}
 
+BitArchiveItem::BitArchiveItem( uint32_t item_index, const shared_ptr< const BitArchiveCatalog >& catalog )
+    : mItemIndex( item_index ), mCatalog( catalog ) {}
+
 BitArchiveItem::~BitArchiveItem() {}
 
 uint32_t BitArchiveItem::index() const {
@@ -77,14 +81,40 @@ uint64_t BitArchiveItem::packSize() const {
 }
 
 BitPropVariant BitArchiveItem::getProperty( BitProperty property ) const {
+    if ( mCatalog ) { // the properties not stored in the catalog are retrieved from the archive
+        return mCatalog->getProperty( mItemIndex, property );
+    }
     auto prop_it = mItemProperties.find( property );
     return ( prop_it != mItemProperties.end() ? ( *prop_it ).second : BitPropVariant() );
 }
 
 map<BitProperty, BitPropVariant> BitArchiveItem::itemProperties() const {
-    return mItemProperties;
+    map< BitProperty, BitPropVariant > result = mItemProperties;
+    if ( mCatalog ) {
+        for ( auto i = static_cast< uint32_t >( BitProperty::NoProperty );
+                i <= static_cast< uint32_t >( BitProperty::CopyLink ); ++i ) {
+            auto property = static_cast< BitProperty >( i );
+            if ( BitArchiveCatalog::isStored( property ) ) {
+                BitPropVariant value = mCatalog->getProperty( mItemIndex, property );
+                if ( !value.isEmpty() ) {
+                    result[ property ] = value;
+                }
+            }
+        }
+        for ( BitProperty property : mCatalog->otherProperties() ) {
+            BitPropVariant value = mCatalog->getProperty( mItemIndex, property );
+            if ( !value.isEmpty() ) {
+                result[ property ] = value;
+            }
+        }
+    }
+    return result;
 }
 
 void BitArchiveItem::setProperty( BitProperty property, const BitPropVariant& value ) {
     mItemProperties[ property ] = value;
 }
+
+void BitArchiveItem::setProperty( BitProperty property, BitPropVariant&& value ) {
+    mItemProperties[ property ] = std::move( value );
+}
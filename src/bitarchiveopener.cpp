@@ -24,10 +24,49 @@
 using namespace bit7z;
 
 BitArchiveOpener::BitArchiveOpener( const Bit7zLibrary& lib, const BitInFormat& format )
-    : BitArchiveHandler( lib ), mFormat( format ) {}
+    : BitArchiveHandler( lib ), mFormat( format ), mThreadsCount( 0 ), mMemoryUsageLimit( 0 ),
+      mInputMode( BitInputMode::FileStream ), mMappingViewLimit( 0 ),
+      mFreeSpaceCheck( false ) {}
 
 BitArchiveOpener::~BitArchiveOpener() {}
 
 const BitInFormat& BitArchiveOpener::extractionFormat() {
     return mFormat;
 }
+
+uint32_t BitArchiveOpener::threadsCount() const {
+    return mThreadsCount;
+}
+
+uint64_t BitArchiveOpener::memoryUsageLimit() const {
+    return mMemoryUsageLimit;
+}
+
+BitInputMode BitArchiveOpener::inputMode() const {
+    return mInputMode;
+}
+
+uint64_t BitArchiveOpener::mappingViewLimit() const {
+    return mMappingViewLimit;
+}
+
+bool BitArchiveOpener::freeSpaceCheck() const {
+    return mFreeSpaceCheck;
+}
+
+void BitArchiveOpener::setThreadsCount( uint32_t threads_count ) {
+    mThreadsCount = threads_count;
+}
+
+void BitArchiveOpener::setMemoryUsageLimit( uint64_t memory_limit ) {
+    mMemoryUsageLimit = memory_limit;
+}
+
+void BitArchiveOpener::setInputMode( BitInputMode input_mode, uint64_t view_size_limit ) {
+    mInputMode = input_mode;
+    mMappingViewLimit = view_size_limit;
+}
+
+void BitArchiveOpener::setFreeSpaceCheck( bool check_free_space ) {
+    mFreeSpaceCheck = check_free_space;
+}
@@ -0,0 +1,93 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/bitarchivereader.hpp"
+
+#include "../include/util.hpp"
+
+using namespace bit7z;
+using namespace bit7z::util;
+
+BitArchiveReader::BitArchiveReader( const Bit7zLibrary& lib, const wstring& in_file, const BitInFormat& format,
+                                    const wstring& password ) : BitArchiveInfo( lib, in_file, format, password ) {}
+
+BitArchiveReader::BitArchiveReader( const Bit7zLibrary& lib, const vector< byte_t >& in_buffer,
+                                    const BitInFormat& format, const wstring& password )
+    : BitArchiveInfo( lib, in_buffer, format, password ) {}
+
+void BitArchiveReader::extract( const wstring& out_dir ) const {
+    extractToFileSystem( mInArchive, *this, mInFile, out_dir, vector< uint32_t >() );
+}
+
+void BitArchiveReader::extractMatching( const wstring& item_filter, const wstring& out_dir ) const {
+    vector< uint32_t > matched_indices = matchingIndices( mInArchive, item_filter );
+    if ( !matched_indices.empty() ) {
+        extractToFileSystem( mInArchive, *this, mInFile, out_dir, matched_indices );
+    }
+}
+
+void BitArchiveReader::extractMatching( const vector< wstring >& item_filters, const wstring& out_dir,
+                                        bool case_sensitive ) const {
+    vector< uint32_t > matched_indices = matchingIndices( mInArchive, item_filters, case_sensitive );
+    if ( !matched_indices.empty() ) {
+        extractToFileSystem( mInArchive, *this, mInFile, out_dir, matched_indices );
+    }
+}
+
+void BitArchiveReader::extractItems( const vector< uint32_t >& indices, const wstring& out_dir ) const {
+    extractToFileSystem( mInArchive, *this, mInFile, out_dir, indices );
+}
+
+void BitArchiveReader::extract( vector< byte_t >& out_buffer, unsigned int index ) const {
+    extractToBuffer( mInArchive, *this, out_buffer, index );
+}
+
+void BitArchiveReader::extract( BitChunkedBuffer& out_buffer, unsigned int index ) const {
+    extractToBuffer( mInArchive, *this, out_buffer, index );
+}
+
+void BitArchiveReader::extractItems( const vector< uint32_t >& indices, BitItemsBuffer& out_items ) const {
+    extractToItemsBuffer( mInArchive, *this, indices, out_items );
+}
+
+void BitArchiveReader::extractMatching( const ItemPredicate& predicate, BitItemsBuffer& out_items ) const {
+    vector< uint32_t > matched_indices = matchingIndices( mInArchive, predicate );
+    if ( matched_indices.empty() ) {
+        out_items.clear();
+        return;
+    }
+    extractToItemsBuffer( mInArchive, *this, matched_indices, out_items );
+}
+
+void BitArchiveReader::extractToSinks( const SinkFactory& sink_factory, const vector< uint32_t >& indices ) const {
+    util::extractToSinks( mInArchive, *this, sink_factory, indices );
+}
+
+void BitArchiveReader::test() const {
+    testArchive( mInArchive, *this, mInFile );
+}
+
+const BitPathIndex& BitArchiveReader::pathIndex() const {
+    if ( !mPathIndex ) {
+        mPathIndex.reset( new BitPathIndex( *this ) );
+    }
+    return *mPathIndex;
+}
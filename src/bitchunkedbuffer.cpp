@@ -0,0 +1,123 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/bitchunkedbuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../include/bitexception.hpp"
+
+using namespace bit7z;
+
+BitChunkedBuffer::BitChunkedBuffer( size_t chunk_size ) : mChunkSize( chunk_size ), mSize( 0 ) {
+    if ( chunk_size == 0 ) {
+        throw BitException( "The chunk size must be greater than zero" );
+    }
+}
+
+size_t BitChunkedBuffer::size() const {
+    return mSize;
+}
+
+bool BitChunkedBuffer::empty() const {
+    return mSize == 0;
+}
+
+size_t BitChunkedBuffer::chunkSize() const {
+    return mChunkSize;
+}
+
+void BitChunkedBuffer::write( size_t offset, const byte_t* data, size_t size ) {
+    if ( size == 0 ) {
+        return;
+    }
+    if ( offset > mSize ) {
+        resize( offset );
+    }
+    grow( offset + size );
+    while ( size > 0 ) {
+        size_t chunk_offset = offset % mChunkSize;
+        size_t count = std::min( size, mChunkSize - chunk_offset );
+        std::memcpy( mChunks[ offset / mChunkSize ].get() + chunk_offset, data, count );
+        offset += count;
+        data += count;
+        size -= count;
+    }
+}
+
+void BitChunkedBuffer::append( const byte_t* data, size_t size ) {
+    write( mSize, data, size );
+}
+
+void BitChunkedBuffer::resize( size_t size ) {
+    if ( size > mSize ) {
+        size_t offset = mSize;
+        grow( size );
+        while ( offset < size ) {
+            size_t chunk_offset = offset % mChunkSize;
+            size_t count = std::min( size - offset, mChunkSize - chunk_offset );
+            std::memset( mChunks[ offset / mChunkSize ].get() + chunk_offset, 0, count );
+            offset += count;
+        }
+    } else {
+        mChunks.resize( ( size + mChunkSize - 1 ) / mChunkSize );
+        mSize = size;
+    }
+}
+
+void BitChunkedBuffer::clear() {
+    mChunks.clear();
+    mSize = 0;
+}
+
+vector< BitBufferSegment > BitChunkedBuffer::segments() const {
+    vector< BitBufferSegment > result;
+    result.reserve( mChunks.size() );
+    size_t remaining = mSize;
+    for ( const auto& chunk : mChunks ) {
+        BitBufferSegment segment = { chunk.get(), std::min( remaining, mChunkSize ) };
+        result.push_back( segment );
+        remaining -= segment.size;
+    }
+    return result;
+}
+
+void BitChunkedBuffer::coalesce( vector< byte_t >& out_buffer ) {
+    out_buffer.reserve( out_buffer.size() + mSize );
+    size_t remaining = mSize;
+    for ( auto& chunk : mChunks ) {
+        size_t count = std::min( remaining, mChunkSize );
+        out_buffer.insert( out_buffer.end(), chunk.get(), chunk.get() + count );
+        chunk.reset();
+        remaining -= count;
+    }
+    clear();
+}
+
+void BitChunkedBuffer::grow( size_t size ) {
+    // The new chunks are not initialized: the content past the current size is always written (or zero-filled) first
+    while ( mChunks.size() * mChunkSize < size ) {
+        mChunks.emplace_back( new byte_t[ mChunkSize ] );
+    }
+    mSize = std::max( mSize, size );
+}
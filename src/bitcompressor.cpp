@@ -23,15 +23,18 @@
 
 #include "7zip/Archive/IArchive.h"
 #include "7zip/Common/FileStreams.h"
+#include "Windows/FileDir.h"
 
 #include "../include/fsitem.hpp"
 #include "../include/util.hpp"
 #include "../include/bitexception.hpp"
-#include "../include/coutmemstream.hpp"
+#include "../include/coutchunkedstream.hpp"
 #include "../include/coutmultivolstream.hpp"
 #include "../include/memupdatecallback.hpp"
 #include "../include/updatecallback.hpp"
+#include "../include/zipmerger.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -70,6 +73,25 @@ void compressOut( const CMyComPtr< IOutArchive >& out_arc, CMyComPtr< T > out_st
     }
 }
 
+/* Compresses the single file in in_items into multiple members (see BitArchiveCreator::setChunkSize), reading the
+ * chunks from the file on behalf of the threads compressing them. */
+void compressMembersOut( const BitArchiveCreator& creator, const Bit7zLibrary& lib, ISequentialOutStream* out_stream,
+                         const vector< FSItem >& in_items ) {
+    if ( in_items.size() != 1 || in_items[ 0 ].isDir() ) {
+        throw BitException( "Only a single file can be compressed into multiple members!" );
+    }
+    const FSItem& in_item = in_items[ 0 ];
+
+    auto* in_file_stream_spec = new CInFileStream;
+    CMyComPtr< IInStream > in_file_stream( in_file_stream_spec );
+    if ( !in_file_stream_spec->Open( in_item.path().c_str() ) ) {
+        throw BitException( L"Cannot open file '" + in_item.path() + L"'" );
+    }
+
+    compressMembers( lib, creator, in_item.size(), streamChunkReader( in_file_stream ), in_item.inArchivePath(),
+                     out_stream );
+}
+
 BitCompressor::BitCompressor( const Bit7zLibrary& lib, const BitInOutFormat& format )
     : BitArchiveCreator( lib, format ) {}
 
@@ -122,9 +144,240 @@ void BitCompressor::compressDirectory( const wstring& in_dir, const wstring& out
     compressFiles( in_dir, out_archive, true, L"" );
 }
 
+void BitCompressor::compressParallel( const vector< wstring >& in_paths, const wstring& out_archive ) const {
+    if ( mFormat != BitFormat::Zip ) {
+        throw BitException( "Parallel compression is supported only by the ZIP format!" );
+    }
+    if ( mVolumeSize > 0 ) {
+        throw BitException( "Parallel compression cannot create multi-volume archives!" );
+    }
+    vector< FSItem > fs_items = FSIndexer::indexPaths( in_paths );
+    uint32_t threads_count = effectiveThreadsCount();
+
+    /* Splitting the items in groups of consecutive items (so that the order of the entries is kept), aiming at four
+     * groups for each thread so that the workers stay balanced even if the sizes of the items are uneven. */
+    uint64_t total_size = 0;
+    for ( const auto& item : fs_items ) {
+        total_size += item.size();
+    }
+    const uint64_t group_size = std::max< uint64_t >( total_size / ( 4ull * threads_count ), 1 );
+    vector< pair< size_t, size_t > > groups; // [first, last) ranges of items
+    uint64_t current_size = 0;
+    for ( size_t i = 0; i < fs_items.size(); ++i ) {
+        if ( groups.empty() || current_size >= group_size ) {
+            groups.emplace_back( i, i );
+            current_size = 0;
+        }
+        groups.back().second = i + 1;
+        current_size += fs_items[ i ].size();
+    }
+
+    /* The parts are created empty, with unique names, in the directory of the output archive (so that no existing file
+     * is ever overwritten), and they are the only files deleted in case of failure. */
+    wstring parts_dir = fsutil::dirname( fsutil::absolute_path( out_archive ) ) + L"\\";
+    vector< wstring > parts;
+    try {
+        for ( size_t i = 0; i < groups.size(); ++i ) {
+            wchar_t part_path[ MAX_PATH ];
+            if ( GetTempFileName( parts_dir.c_str(), L"bit", 0, part_path ) == 0 ) {
+                throw BitException( L"Can't create a temporary file in '" + parts_dir + L"'" );
+            }
+            parts.push_back( part_path );
+        }
+        parallelFor( static_cast< uint32_t >( groups.size() ), threads_count, [&]( uint32_t group, uint32_t ) {
+            vector< FSItem > group_items( fs_items.begin() + static_cast< ptrdiff_t >( groups[ group ].first ),
+                                          fs_items.begin() + static_cast< ptrdiff_t >( groups[ group ].second ) );
+            // each group is compressed by a single thread, since the groups are already compressed concurrently
+            CMyComPtr< IOutArchive > out_arc = initOutArchive( mLibrary, *this, 1 );
+            auto* part_stream_spec = new COutFileStream();
+            CMyComPtr< IOutStream > part_stream = part_stream_spec;
+            if ( !part_stream_spec->Open( parts[ group ].c_str(), OPEN_EXISTING ) ) {
+                throw BitException( L"Can't create archive file '" + parts[ group ] + L"'" );
+            }
+            compressOut( out_arc, part_stream, group_items, *this );
+        } );
+
+        auto* out_file_stream_spec = new COutFileStream();
+        CMyComPtr< IOutStream > out_file_stream = out_file_stream_spec;
+        if ( !out_file_stream_spec->Create( out_archive.c_str(), false ) ) {
+            throw BitException( L"Can't create archive file '" + out_archive + L"'" );
+        }
+        ZipMerger merger( out_file_stream );
+        for ( const auto& part : parts ) {
+            merger.append( part );
+            NFile::NDir::DeleteFileAlways( part.c_str() );
+        }
+        merger.finalize();
+    } catch ( ... ) {
+        for ( const auto& part : parts ) {
+            NFile::NDir::DeleteFileAlways( part.c_str() );
+        }
+        throw;
+    }
+}
+
+vector< BitShard > BitCompressor::compressSharded( const vector< wstring >& in_paths, const wstring& out_archive,
+                                                   uint32_t shards_count ) const {
+    vector< FSItem > fs_items = FSIndexer::indexPaths( in_paths );
+    const uint32_t threads_count = effectiveThreadsCount();
+    if ( shards_count == 0 ) {
+        shards_count = threads_count;
+    }
+    shards_count = static_cast< uint32_t >( std::min< size_t >( shards_count, std::max< size_t >( fs_items.size(), 1 ) ) );
+
+    // Grouping the items by their parent directory (in the archive), keeping the order of the first appearance
+    uint64_t total_size = 0;
+    vector< vector< size_t > > groups;
+    vector< uint64_t > groups_sizes;
+    map< wstring, size_t > directory_groups;
+    for ( size_t i = 0; i < fs_items.size(); ++i ) {
+        wstring directory = fsutil::dirname( fs_items[ i ].inArchivePath() );
+        auto group_it = directory_groups.find( directory );
+        if ( group_it == directory_groups.end() ) {
+            group_it = directory_groups.insert( make_pair( directory, groups.size() ) ).first;
+            groups.push_back( vector< size_t >() );
+            groups_sizes.push_back( 0 );
+        }
+        groups[ group_it->second ].push_back( i );
+        groups_sizes[ group_it->second ] += fs_items[ i ].size();
+        total_size += fs_items[ i ].size();
+    }
+
+    // The groups bigger than the average shard cannot be balanced as a whole, so their items are assigned one by one
+    const uint64_t shard_size = total_size / shards_count;
+    vector< pair< uint64_t, vector< size_t > > > units; // (size, items)
+    for ( size_t g = 0; g < groups.size(); ++g ) {
+        if ( groups_sizes[ g ] > shard_size && groups[ g ].size() > 1 ) {
+            for ( size_t item : groups[ g ] ) {
+                units.emplace_back( fs_items[ item ].size(), vector< size_t >( 1, item ) );
+            }
+        } else {
+            units.emplace_back( groups_sizes[ g ], groups[ g ] );
+        }
+    }
+    std::stable_sort( units.begin(), units.end(), []( const pair< uint64_t, vector< size_t > >& a,
+                                                      const pair< uint64_t, vector< size_t > >& b ) {
+        return a.first > b.first;
+    } );
+
+    vector< vector< size_t > > shards_items( shards_count );
+    vector< uint64_t > shards_sizes( shards_count, 0 );
+    for ( const auto& unit : units ) {
+        auto shard = static_cast< size_t >( std::min_element( shards_sizes.begin(), shards_sizes.end() ) -
+                                            shards_sizes.begin() );
+        shards_items[ shard ].insert( shards_items[ shard ].end(), unit.second.begin(), unit.second.end() );
+        shards_sizes[ shard ] += unit.first;
+    }
+
+    // Naming the (non empty) shards after the output archive, e.g. "backup.7z" -> "backup.001.7z"
+    wstring directory = fsutil::dirname( out_archive );
+    wstring extension = fsutil::extension( out_archive );
+    wstring stem = fsutil::filename( out_archive, true );
+    stem.resize( stem.size() - ( extension.empty() ? 0 : extension.size() + 1 ) );
+    wstring prefix = ( directory.empty() ? L"" : directory + L"\\" ) + stem;
+    vector< BitShard > result;
+    vector< vector< FSItem > > shards_fs_items;
+    for ( size_t shard = 0; shard < shards_count; ++shard ) {
+        if ( shards_items[ shard ].empty() ) {
+            continue;
+        }
+        std::sort( shards_items[ shard ].begin(), shards_items[ shard ].end() );
+        wstring number = to_wstring( result.size() + 1 );
+        if ( number.size() < 3 ) {
+            number.insert( 0, 3 - number.size(), L'0' );
+        }
+        BitShard shard_info;
+        shard_info.archivePath = prefix + L"." + number + ( extension.empty() ? L"" : L"." + extension );
+        shard_info.size = shards_sizes[ shard ];
+        shards_fs_items.push_back( vector< FSItem >() );
+        for ( size_t item : shards_items[ shard ] ) {
+            shard_info.items.push_back( fs_items[ item ].inArchivePath() );
+            shards_fs_items.back().push_back( fs_items[ item ] );
+        }
+        result.push_back( shard_info );
+    }
+
+    if ( result.empty() ) {
+        return result;
+    }
+
+    /* The shards and the manifest are never overwritten: checking it in advance ensures that all the shard files
+     * (and their volumes) have been created by this call, hence they can be deleted if any of them fails. */
+    wstring manifest_path = prefix + L".manifest";
+    if ( fsutil::path_exists( manifest_path ) ) {
+        throw BitException( L"Can't create manifest file '" + manifest_path + L"' (it already exists)" );
+    }
+    for ( const auto& shard : result ) {
+        wstring first_file = mVolumeSize > 0 ? shard.archivePath + L".001" : shard.archivePath;
+        if ( fsutil::path_exists( first_file ) ) {
+            throw BitException( L"Can't create archive file '" + first_file + L"' (it already exists)" );
+        }
+    }
+    auto shards = static_cast< uint32_t >( result.size() );
+    const uint32_t shard_threads = std::max( threads_count / std::max( shards, 1u ), 1u );
+    bool manifest_created = false;
+    try {
+        parallelFor( shards, threads_count, [&]( uint32_t shard, uint32_t ) {
+            compressToFileSystem( shards_fs_items[ shard ], result[ shard ].archivePath, shard_threads );
+        } );
+
+        // The manifest maps each item to the file name of its shard
+        wstring manifest;
+        for ( const auto& shard : result ) {
+            wstring shard_name = fsutil::filename( shard.archivePath, true );
+            for ( const auto& item : shard.items ) {
+                manifest += shard_name + L"\t" + item + L"\n";
+            }
+        }
+        int size = WideCharToMultiByte( CP_UTF8, 0, manifest.c_str(), static_cast< int >( manifest.size() ),
+                                        nullptr, 0, nullptr, nullptr );
+        vector< byte_t > manifest_data( static_cast< size_t >( std::max( size, 0 ) ) );
+        WideCharToMultiByte( CP_UTF8, 0, manifest.c_str(), static_cast< int >( manifest.size() ),
+                             reinterpret_cast< char* >( manifest_data.data() ), size, nullptr, nullptr );
+        auto* manifest_stream_spec = new COutFileStream();
+        CMyComPtr< IOutStream > manifest_stream = manifest_stream_spec;
+        if ( !manifest_stream_spec->Create( manifest_path.c_str(), false ) ) {
+            throw BitException( L"Can't create manifest file '" + manifest_path + L"'" );
+        }
+        manifest_created = true;
+        writeBuffer( manifest_stream, manifest_data );
+    } catch ( ... ) {
+        // note: the manifest stream has already been closed, since it is destroyed before entering this handler
+        if ( manifest_created ) {
+            NFile::NDir::DeleteFileAlways( manifest_path.c_str() );
+        }
+        for ( const auto& shard : result ) {
+            if ( mVolumeSize == 0 ) {
+                NFile::NDir::DeleteFileAlways( shard.archivePath.c_str() );
+                continue;
+            }
+            for ( uint32_t volume = 1; ; ++volume ) {
+                wstring number = to_wstring( volume );
+                if ( number.size() < 3 ) {
+                    number.insert( 0, 3 - number.size(), L'0' );
+                }
+                wstring volume_path = shard.archivePath + L"." + number;
+                if ( !fsutil::path_exists( volume_path ) ) {
+                    break;
+                }
+                NFile::NDir::DeleteFileAlways( volume_path.c_str() );
+            }
+        }
+        throw;
+    }
+    return result;
+}
+
 /* from filesystem to memory buffer */
 
 void BitCompressor::compressFile( const wstring& in_file, vector< byte_t >& out_buffer ) const {
+    // The archive is written in chunks and then copied once into the vector, avoiding its repeated reallocations
+    BitChunkedBuffer out_chunks;
+    compressFile( in_file, out_chunks );
+    out_chunks.coalesce( out_buffer );
+}
+
+void BitCompressor::compressFile( const wstring& in_file, BitChunkedBuffer& out_buffer ) const {
     FSItem item( in_file );
     if ( item.isDir() ) {
         throw BitException( "Cannot compress a directory into a memory buffer!" );
@@ -138,8 +391,10 @@ void BitCompressor::compressFile( const wstring& in_file, vector< byte_t >& out_
  * Main changes made:
  *  + Generalized the code to work with any type of format (original works only with 7z format)
  *  + Use of exceptions instead of error codes */
-void BitCompressor::compressToFileSystem( const vector< FSItem >& in_items, const wstring& out_archive ) const {
-    CMyComPtr< IOutArchive > out_arc = initOutArchive( mLibrary, mFormat, mCompressionLevel, mCryptHeaders, mSolidMode );
+void BitCompressor::compressToFileSystem( const vector< FSItem >& in_items, const wstring& out_archive,
+                                          uint32_t threads_count ) const {
+    // the chunked compression creates its own archive handlers (one for each member)
+    CMyComPtr< IOutArchive > out_arc = mChunkSize > 0 ? nullptr : initOutArchive( mLibrary, *this, threads_count );
 
     CMyComPtr< IOutStream > out_file_stream;
     if ( mVolumeSize > 0 ) {
@@ -155,11 +410,15 @@ void BitCompressor::compressToFileSystem( const vector< FSItem >& in_items, cons
         }
     }
 
+    if ( mChunkSize > 0 ) {
+        compressMembersOut( *this, mLibrary, out_file_stream, in_items );
+        return;
+    }
     compressOut( out_arc, out_file_stream, in_items, *this );
 }
 
 // FS -> Memory
-void BitCompressor::compressToMemory( const vector< FSItem >& in_items, vector< byte_t >& out_buffer ) const {
+void BitCompressor::compressToMemory( const vector< FSItem >& in_items, BitChunkedBuffer& out_buffer ) const {
     if ( in_items.empty() ) {
         throw BitException( "The list of files/directories cannot be empty!" );
     }
@@ -167,10 +426,15 @@ void BitCompressor::compressToMemory( const vector< FSItem >& in_items, vector<
         throw BitException( "Unsupported format for in-memory compression!" );
     }
 
-    CMyComPtr< IOutArchive > out_arc = initOutArchive( mLibrary, mFormat, mCompressionLevel, mCryptHeaders, mSolidMode );
+    // the chunked compression creates its own archive handlers (one for each member)
+    CMyComPtr< IOutArchive > out_arc = mChunkSize > 0 ? nullptr : initOutArchive( mLibrary, *this );
 
-    auto* out_mem_stream_spec = new COutMemStream( out_buffer );
-    CMyComPtr< ISequentialOutStream > out_mem_stream( out_mem_stream_spec );
+    auto* out_mem_stream_spec = new COutChunkedStream( out_buffer );
+    CMyComPtr< IOutStream > out_mem_stream( out_mem_stream_spec );
 
-    compressOut( out_arc, out_mem_stream, in_items, *this );
+    if ( mChunkSize > 0 ) {
+        compressMembersOut( *this, mLibrary, out_mem_stream, in_items );
+    } else {
+        compressOut( out_arc, out_mem_stream, in_items, *this );
+    }
 }
@@ -22,23 +22,31 @@
 #include "../include/bitextractor.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <map>
+#include <numeric>
 
 #include "7zip/Archive/IArchive.h"
+#include "7zip/Common/FileStreams.h"
+#include "Windows/FileDir.h"
 
 #include "../include/bitpropvariant.hpp"
 #include "../include/bitexception.hpp"
-#include "../include/extractcallback.hpp"
-#include "../include/memextractcallback.hpp"
-#include "../include/fsutil.hpp"
 #include "../include/util.hpp"
+#include "../include/coutmemstream.hpp"
+#include "../include/fsutil.hpp"
 
 using namespace bit7z;
-using namespace bit7z::filesystem;
 using namespace bit7z::util;
 using namespace NWindows;
-using namespace NArchive;
+using namespace bit7z::filesystem;
 
 using std::wstring;
+using std::map;
+
+double BitWorkerStats::throughput() const {
+    return elapsedTime > 0 ? ( 1000.0 * unpackSize ) / elapsedTime : 0.0;
+}
 
 BitExtractor::BitExtractor( const Bit7zLibrary& lib, const BitInFormat& format ) : BitArchiveOpener( lib, format ) {}
 
@@ -46,8 +54,6 @@ void BitExtractor::extract( const wstring& in_file, const wstring& out_dir ) con
     extractItems( in_file, vector< uint32_t >(), out_dir );
 }
 
-//TODO: Improve reusing of code (both extract methods do the same operations when opening an archive)
-
 /* Most of this code, though heavily modified, is taken from the main() of Client7z.cpp in the 7z SDK
  * Main changes made:
  *  + Generalized the code to work with any type of format (the original works only with 7z format)
@@ -55,88 +61,204 @@ void BitExtractor::extract( const wstring& in_file, const wstring& out_dir ) con
 void BitExtractor::extractMatching( const wstring& in_file, const wstring& item_filter, const wstring& out_dir ) const {
     CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
 
-    vector<uint32_t> matched_indices;
     // TODO: Use BitArchiveReader here
-    if ( !item_filter.empty() ) {
-        //Searching for files inside the archive that match the given filter
-        uint32_t items_count;
-        HRESULT result = in_archive->GetNumberOfItems( &items_count );
-        if ( result == S_OK ) {
-            for ( uint32_t index = 0; index < items_count; ++index ) {
-                BitPropVariant propvar;
-                result = in_archive->GetProperty( index, kpidPath, &propvar );
-                if ( result == S_OK && !propvar.isEmpty() && propvar.type() == BitPropVariantType::String &&
-                        fsutil::wildcard_match( item_filter, propvar.getString() ) ) {
-                    matched_indices.push_back( index );
-                }
-            }
-        }
+    vector< uint32_t > matched_indices = matchingIndices( in_archive, item_filter );
+    if ( !matched_indices.empty() ) {
+        extractToFileSystem( in_archive, *this, in_file, out_dir, matched_indices );
     }
+}
 
+void BitExtractor::extractMatching( const wstring& in_file, const vector< wstring >& item_filters,
+                                    const wstring& out_dir, bool case_sensitive ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    vector< uint32_t > matched_indices = matchingIndices( in_archive, item_filters, case_sensitive );
     if ( !matched_indices.empty() ) {
-        extractToFileSystem( in_archive, in_file, out_dir, matched_indices );
+        extractToFileSystem( in_archive, *this, in_file, out_dir, matched_indices );
     }
 }
 
 void BitExtractor::extractItems( const wstring& in_file, const vector<uint32_t>& indices, const wstring& out_dir ) const {
+    // Extracting all the items (i.e. no indices specified) reads the whole archive sequentially
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this, indices.empty() );
+    extractToFileSystem( in_archive, *this, in_file, out_dir, indices );
+}
+
+vector< BitWorkerStats > BitExtractor::extractParallel( const wstring& in_file, const wstring& out_dir,
+                                                        uint32_t threads_count ) const {
     CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
 
-    uint32_t number_items;
-    in_archive->GetNumberOfItems( &number_items );
-    if ( std::any_of( indices.begin(), indices.end(), [&]( uint32_t index ) { return index >= number_items; }) ) {
-        /* if any of the indices is greater than the number of items in the archive we throw an exception, since it is
-           an invalid index! */
-        throw BitException( "Some index is not valid" );
+    uint32_t items_count = itemsCount( in_archive );
+    if ( items_count == 0 ) {
+        return vector< BitWorkerStats >();
     }
 
-    extractToFileSystem( in_archive, in_file, out_dir, indices );
-}
-
-void BitExtractor::extract( const wstring& in_file, vector< byte_t >& out_buffer, unsigned int index ) {
-    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    /* Items are grouped by solid block (kpidBlock), so that each block is decoded by only one worker.
+     * Items without a block (e.g. the entries of non-solid formats like ZIP and TAR, or the folders and the empty files
+     * of 7z archives) can be extracted independently, hence each one of them forms a group on its own; however, some
+     * handlers of solid formats (e.g. RAR) do not expose the blocks: the solid items without a block (according to
+     * the kpidSolid property of the archive or of the item) are all put in a single group, so that the solid stream
+     * is decoded only once. */
+    BitPropVariant archive_solid_prop;
+    bool solid_archive = in_archive->GetArchiveProperty( kpidSolid, &archive_solid_prop ) == S_OK &&
+                         archive_solid_prop.isBool() && archive_solid_prop.getBool();
+    vector< vector< uint32_t > > groups;
+    vector< uint64_t > groups_sizes;
+    map< uint32_t, size_t > block_groups;
+    size_t solid_group = static_cast< size_t >( -1 );
+    for ( uint32_t index = 0; index < items_count; ++index ) {
+        BitPropVariant size_prop;
+        in_archive->GetProperty( index, kpidSize, &size_prop );
+        uint64_t item_size = size_prop.isUInt64() ? size_prop.getUInt64() : 0;
 
-    uint32_t number_items;
-    in_archive->GetNumberOfItems( &number_items );
-    if ( index >= number_items ) {
-        throw BitException( "Index " + std::to_string( index ) + " is out of range"  );
+        BitPropVariant block_prop;
+        HRESULT res = in_archive->GetProperty( index, kpidBlock, &block_prop );
+        size_t group_index = groups.size();
+        if ( res == S_OK && block_prop.isUInt32() ) {
+            auto block_it = block_groups.find( block_prop.getUInt32() );
+            if ( block_it != block_groups.end() ) {
+                group_index = block_it->second;
+            } else {
+                block_groups[ block_prop.getUInt32() ] = group_index;
+            }
+        } else {
+            BitPropVariant solid_prop;
+            bool solid_item = solid_archive || ( in_archive->GetProperty( index, kpidSolid, &solid_prop ) == S_OK &&
+                                                 solid_prop.isBool() && solid_prop.getBool() );
+            if ( solid_item ) {
+                if ( solid_group == static_cast< size_t >( -1 ) ) {
+                    solid_group = group_index;
+                }
+                group_index = solid_group;
+            }
+        }
+        if ( group_index == groups.size() ) {
+            groups.push_back( vector< uint32_t >() );
+            groups_sizes.push_back( 0 );
+        }
+        groups[ group_index ].push_back( index );
+        groups_sizes[ group_index ] += item_size;
     }
 
-    auto* extract_callback_spec = new MemExtractCallback( *this, in_archive, out_buffer );
+    if ( threads_count == 0 ) {
+        threads_count = hardwareThreads();
+    }
+    threads_count = static_cast< uint32_t >( std::min< size_t >( threads_count, groups.size() ) );
 
-    const uint32_t indices[] = { index };
+    // Assigning the biggest groups first, each one to the worker with the smallest workload so far
+    vector< size_t > groups_order( groups.size() );
+    std::iota( groups_order.begin(), groups_order.end(), 0 );
+    std::stable_sort( groups_order.begin(), groups_order.end(), [&]( size_t a, size_t b ) {
+        return groups_sizes[ a ] > groups_sizes[ b ];
+    } );
 
-    CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
-    if ( in_archive->Extract( indices, 1, NExtract::NAskMode::kExtract, extract_callback ) != S_OK ) {
-        throw BitException( extract_callback_spec->getErrorMessage() );
+    vector< vector< uint32_t > > workers_items( threads_count );
+    vector< BitWorkerStats > workers_stats( threads_count, BitWorkerStats() );
+    for ( size_t group_index : groups_order ) {
+        auto worker_it = std::min_element( workers_stats.begin(), workers_stats.end(),
+                                           []( const BitWorkerStats& a, const BitWorkerStats& b ) {
+            return a.unpackSize < b.unpackSize || ( a.unpackSize == b.unpackSize && a.itemsCount < b.itemsCount );
+        } );
+        auto worker = static_cast< size_t >( worker_it - workers_stats.begin() );
+        const vector< uint32_t >& group = groups[ group_index ];
+        workers_items[ worker ].insert( workers_items[ worker ].end(), group.begin(), group.end() );
+        worker_it->itemsCount += static_cast< uint32_t >( group.size() );
+        worker_it->unpackSize += groups_sizes[ group_index ];
     }
+
+    parallelFor( threads_count, threads_count, [&]( uint32_t worker, uint32_t ) {
+        auto start = std::chrono::steady_clock::now();
+        // The first worker reuses the archive opened for partitioning the items, the others open their own one
+        CMyComPtr< IInArchive > worker_archive = worker == 0 ? in_archive :
+                                                 openArchive( mLibrary, mFormat, in_file, *this );
+        extractToFileSystem( worker_archive, *this, in_file, out_dir, workers_items[ worker ] );
+        workers_stats[ worker ].elapsedTime = static_cast< uint64_t >(
+            std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - start ).count() );
+    } );
+    return workers_stats;
 }
 
-void BitExtractor::test( const wstring& in_file ) {
-    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+/* Opens the input file as a stream and returns its size, so that its members can be read by the extraction workers. */
+CMyComPtr< IInStream > openMembersStream( const wstring& in_file, uint64_t& in_size ) {
+    auto* file_stream_spec = new CInFileStream;
+    CMyComPtr< IInStream > file_stream = file_stream_spec;
+    if ( !file_stream_spec->Open( in_file.c_str() ) || file_stream_spec->GetSize( &in_size ) != S_OK ) {
+        throw BitException( L"Cannot open archive file '" + in_file + L"'" );
+    }
+    return file_stream;
+}
 
-    auto* extract_callback_spec = new ExtractCallback( *this, in_archive, in_file, L"" );
+void BitExtractor::extractMembers( const wstring& in_file, const wstring& out_dir, uint32_t threads_count ) const {
+    // The name of the output file is the one stored in the (first member of the) archive, as in the usual extraction
+    wstring out_path = out_dir;
+    fsutil::normalize_path( out_path );
+    {
+        CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+        BitPropVariant path_prop;
+        if ( in_archive->GetProperty( 0, kpidPath, &path_prop ) == S_OK && path_prop.isString() ) {
+            out_path += path_prop.getString();
+        } else {
+            out_path += fsutil::filename( in_file );
+        }
+    }
+    if ( !out_dir.empty() ) {
+        NFile::NDir::CreateComplexDir( out_dir.c_str() );
+    }
 
-    CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
-    HRESULT res = in_archive->Extract( nullptr, static_cast< uint32_t >( -1 ), NExtract::NAskMode::kTest, extract_callback );
-    if ( res != S_OK ) {
-        throw BitException( extract_callback_spec->getErrorMessage() + L" (error code: " + std::to_wstring( res ) + L")" );
+    uint64_t in_size = 0;
+    CMyComPtr< IInStream > in_stream = openMembersStream( in_file, in_size );
+    auto* out_file_stream_spec = new COutFileStream();
+    CMyComPtr< IOutStream > out_file_stream = out_file_stream_spec;
+    if ( !out_file_stream_spec->Create( out_path.c_str(), true ) ) {
+        throw BitException( L"Cannot create output file '" + out_path + L"'" );
     }
+    util::extractMembers( mLibrary, mFormat, *this, in_size, streamChunkReader( in_stream ),
+                          fileRangeOpener( in_file ), threads_count, out_file_stream );
 }
 
+void BitExtractor::extractMembers( const wstring& in_file, vector< byte_t >& out_buffer, uint32_t threads_count ) const {
+    uint64_t in_size = 0;
+    CMyComPtr< IInStream > in_stream = openMembersStream( in_file, in_size );
+    out_buffer.clear();
+    auto* out_mem_stream_spec = new COutMemStream( out_buffer );
+    CMyComPtr< ISequentialOutStream > out_mem_stream( out_mem_stream_spec );
+    util::extractMembers( mLibrary, mFormat, *this, in_size, streamChunkReader( in_stream ),
+                          fileRangeOpener( in_file ), threads_count, out_mem_stream );
+}
 
-void BitExtractor::extractToFileSystem( IInArchive* in_archive, const wstring& in_file,
-                                        const wstring& out_dir, const vector<uint32_t>& indices ) const {
+void BitExtractor::extract( const wstring& in_file, vector< byte_t >& out_buffer, unsigned int index ) {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    extractToBuffer( in_archive, *this, out_buffer, index );
+}
 
-    //pointer to an array of the indices of the files to be extracted
-    const uint32_t* item_indices = indices.empty() ? nullptr : indices.data();
-    uint32_t num_items = indices.empty() ? static_cast< uint32_t >( -1 ) :
-                         static_cast< uint32_t >( indices.size() );
+void BitExtractor::extract( const wstring& in_file, BitChunkedBuffer& out_buffer, unsigned int index ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    extractToBuffer( in_archive, *this, out_buffer, index );
+}
 
-    auto* extract_callback_spec = new ExtractCallback( *this, in_archive, in_file, out_dir );
+void BitExtractor::extractItems( const wstring& in_file, const vector< uint32_t >& indices,
+                                 BitItemsBuffer& out_items ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    extractToItemsBuffer( in_archive, *this, indices, out_items );
+}
 
-    CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
-    HRESULT res = in_archive->Extract( item_indices, num_items, NExtract::NAskMode::kExtract, extract_callback );
-    if ( res != S_OK ) {
-        throw BitException( extract_callback_spec->getErrorMessage() + L" (error code: " + std::to_wstring( res ) + L")" );
+void BitExtractor::extractMatching( const wstring& in_file, const ItemPredicate& predicate,
+                                    BitItemsBuffer& out_items ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    vector< uint32_t > matched_indices = matchingIndices( in_archive, predicate );
+    if ( matched_indices.empty() ) {
+        out_items.clear();
+        return;
     }
+    extractToItemsBuffer( in_archive, *this, matched_indices, out_items );
+}
+
+void BitExtractor::extractToSinks( const wstring& in_file, const SinkFactory& sink_factory,
+                                   const vector< uint32_t >& indices ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this );
+    util::extractToSinks( in_archive, *this, sink_factory, indices );
+}
+
+void BitExtractor::test( const wstring& in_file ) {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_file, *this, true );
+    testArchive( in_archive, *this, in_file );
 }
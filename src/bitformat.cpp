@@ -25,20 +25,23 @@ using namespace std;
 
 namespace bit7z {
     namespace BitFormat {
-        const BitInOutFormat Zip( 0x01, L".zip", MULTIPLE_FILES | COMPRESSION_LEVEL | ENCRYPTION );
-        const BitInOutFormat BZip2( 0x02, L".bz2", COMPRESSION_LEVEL | INMEM_COMPRESSION );
+        const BitInOutFormat Zip( 0x01, L".zip", MULTIPLE_FILES | COMPRESSION_LEVEL | ENCRYPTION | INMEM_COMPRESSION |
+                                  MULTITHREADING );
+        const BitInOutFormat BZip2( 0x02, L".bz2", COMPRESSION_LEVEL | INMEM_COMPRESSION | MULTITHREADING |
+                                    MULTIPLE_MEMBERS );
         const BitInFormat Rar( 0x03 );
         const BitInFormat Arj( 0x04 );
         const BitInFormat Z( 0x05 );
         const BitInFormat Lzh( 0x06 );
         const BitInOutFormat SevenZip( 0x07, L".7z", MULTIPLE_FILES | SOLID_ARCHIVE | COMPRESSION_LEVEL |
-                                       ENCRYPTION | HEADER_ENCRYPTION );
+                                       ENCRYPTION | HEADER_ENCRYPTION | INMEM_COMPRESSION | MULTITHREADING );
         const BitInFormat Cab( 0x08 );
         const BitInFormat Nsis( 0x09 );
         const BitInFormat Lzma( 0x0A );
         const BitInFormat Lzma86( 0x0B );
         const BitInOutFormat Xz( 0x0C, L".xz",
-                                 COMPRESSION_LEVEL | ENCRYPTION | HEADER_ENCRYPTION | INMEM_COMPRESSION );
+                                 COMPRESSION_LEVEL | ENCRYPTION | HEADER_ENCRYPTION | INMEM_COMPRESSION |
+                                 MULTITHREADING );
         const BitInFormat Ppmd( 0x0D );
         const BitInFormat COFF( 0xC7 );
         const BitInFormat Ext( 0xC7 );
@@ -72,7 +75,7 @@ namespace bit7z {
         const BitInFormat Hfs( 0xE3 );
         const BitInFormat Dmg( 0xE4 );
         const BitInFormat Compound( 0xE5 );
-        const BitInOutFormat Wim( 0xE6, L".wim", MULTIPLE_FILES );
+        const BitInOutFormat Wim( 0xE6, L".wim", MULTIPLE_FILES | INMEM_COMPRESSION );
         const BitInFormat Iso( 0xE7 );
         const BitInFormat Chm( 0xE9 );
         const BitInFormat Split( 0xEA );
@@ -80,7 +83,7 @@ namespace bit7z {
         const BitInFormat Deb( 0xEC );
         const BitInFormat Cpio( 0xED );
         const BitInOutFormat Tar( 0xEE, L".tar", MULTIPLE_FILES | INMEM_COMPRESSION );
-        const BitInOutFormat GZip( 0xEF, L".gz", COMPRESSION_LEVEL | INMEM_COMPRESSION );
+        const BitInOutFormat GZip( 0xEF, L".gz", COMPRESSION_LEVEL | INMEM_COMPRESSION | MULTIPLE_MEMBERS );
     }
 }
 
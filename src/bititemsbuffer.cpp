@@ -0,0 +1,83 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/bititemsbuffer.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "../include/bitexception.hpp"
+
+using namespace bit7z;
+
+BitItemsBuffer::BitItemsBuffer() {}
+
+const vector< byte_t >& BitItemsBuffer::data() const {
+    return mData;
+}
+
+uint32_t BitItemsBuffer::itemsCount() const {
+    return static_cast< uint32_t >( mSpans.size() );
+}
+
+vector< uint32_t > BitItemsBuffer::indices() const {
+    vector< uint32_t > result;
+    result.reserve( mSpans.size() );
+    for ( const ItemSpan& item_span : mSpans ) {
+        result.push_back( item_span.index );
+    }
+    return result;
+}
+
+bool BitItemsBuffer::contains( uint32_t index ) const {
+    auto it = std::lower_bound( mSpans.begin(), mSpans.end(), index, []( const ItemSpan& item_span, uint32_t idx ) {
+        return item_span.index < idx;
+    } );
+    return it != mSpans.end() && it->index == index;
+}
+
+const byte_t* BitItemsBuffer::itemData( uint32_t index ) const {
+    const ItemSpan& item_span = span( index );
+    return item_span.size > 0 ? &mData[ item_span.offset ] : nullptr;
+}
+
+size_t BitItemsBuffer::itemSize( uint32_t index ) const {
+    return span( index ).size;
+}
+
+void BitItemsBuffer::reserve( size_t size ) {
+    mData.reserve( size );
+}
+
+void BitItemsBuffer::clear() {
+    mData.clear();
+    mSpans.clear();
+}
+
+const BitItemsBuffer::ItemSpan& BitItemsBuffer::span( uint32_t index ) const {
+    auto it = std::lower_bound( mSpans.begin(), mSpans.end(), index, []( const ItemSpan& item_span, uint32_t idx ) {
+        return item_span.index < idx;
+    } );
+    if ( it == mSpans.end() || it->index != index ) {
+        throw BitException( "No content for the item at index " + std::to_string( index ) );
+    }
+    return *it;
+}
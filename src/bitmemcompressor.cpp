@@ -27,7 +27,7 @@
 
 #include "../include/util.hpp"
 #include "../include/bitexception.hpp"
-#include "../include/coutmemstream.hpp"
+#include "../include/coutchunkedstream.hpp"
 #include "../include/coutmultivolstream.hpp"
 #include "../include/fsutil.hpp"
 #include "../include/memupdatecallback.hpp"
@@ -65,7 +65,8 @@ BitMemCompressor::BitMemCompressor( const Bit7zLibrary& lib, const BitInOutForma
 
 void BitMemCompressor::compress( const vector< byte_t >& in_buffer, const wstring& out_archive,
                                  wstring in_buffer_name ) const {
-    CMyComPtr< IOutArchive > out_arc = initOutArchive( mLibrary, mFormat, mCompressionLevel, mCryptHeaders, mSolidMode );
+    // the chunked compression creates its own archive handlers (one for each member)
+    CMyComPtr< IOutArchive > out_arc = mChunkSize > 0 ? nullptr : initOutArchive( mLibrary, *this );
 
     CMyComPtr< IOutStream > out_file_stream;
     if ( mVolumeSize > 0 ) {
@@ -83,19 +84,36 @@ void BitMemCompressor::compress( const vector< byte_t >& in_buffer, const wstrin
         in_buffer_name = fsutil::filename( out_archive );
     }
 
+    if ( mChunkSize > 0 ) {
+        compressMembers( mLibrary, *this, in_buffer.size(), bufferChunkReader( in_buffer ), in_buffer_name, out_file_stream );
+        return;
+    }
     compressOut( out_arc, out_file_stream, in_buffer, in_buffer_name, *this );
 }
 
 void BitMemCompressor::compress( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
                                  const wstring& in_buffer_name ) const {
+    // The archive is written in chunks and then copied once into the vector, avoiding its repeated reallocations
+    BitChunkedBuffer out_chunks;
+    compress( in_buffer, out_chunks, in_buffer_name );
+    out_chunks.coalesce( out_buffer );
+}
+
+void BitMemCompressor::compress( const vector< byte_t >& in_buffer, BitChunkedBuffer& out_buffer,
+                                 const wstring& in_buffer_name ) const {
     if ( !mFormat.hasFeature( INMEM_COMPRESSION ) ) {
         throw BitException( "Unsupported format for in-memory compression!" );
     }
 
-    CMyComPtr< IOutArchive > out_arc = initOutArchive( mLibrary, mFormat, mCompressionLevel, mCryptHeaders, mSolidMode );
+    // the chunked compression creates its own archive handlers (one for each member)
+    CMyComPtr< IOutArchive > out_arc = mChunkSize > 0 ? nullptr : initOutArchive( mLibrary, *this );
 
-    auto* out_mem_stream_spec = new COutMemStream( out_buffer );
-    CMyComPtr< ISequentialOutStream > out_mem_stream( out_mem_stream_spec );
+    auto* out_mem_stream_spec = new COutChunkedStream( out_buffer );
+    CMyComPtr< IOutStream > out_mem_stream( out_mem_stream_spec );
 
+    if ( mChunkSize > 0 ) {
+        compressMembers( mLibrary, *this, in_buffer.size(), bufferChunkReader( in_buffer ), in_buffer_name, out_mem_stream );
+        return;
+    }
     compressOut( out_arc, out_mem_stream, in_buffer, in_buffer_name, *this );
 }
@@ -23,70 +23,61 @@
 
 #include "7zip/Archive/IArchive.h"
 
-#include "../include/bitexception.hpp"
-#include "../include/opencallback.hpp"
-#include "../include/memextractcallback.hpp"
-#include "../include/extractcallback.hpp"
+#include "../include/util.hpp"
+#include "../include/coutmemstream.hpp"
 
 using namespace bit7z;
+using namespace bit7z::util;
 using namespace std;
-using namespace NWindows;
-using namespace NArchive;
-
-// NOTE: this function is not a method of BitMemExtractor because it would dirty the header with extra dependencies
-CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
-                                     const vector< byte_t >& in_buffer, const BitArchiveOpener& opener ) {
-    if ( in_buffer.empty() ) {
-        throw BitException( "Cannot open an empty buffer archive" );
-    }
-
-    CMyComPtr< IInArchive > in_archive;
-    const GUID format_GUID = format.guid();
-    lib.createArchiveObject( &format_GUID, &::IID_IInArchive, reinterpret_cast< void** >( &in_archive ) );
-
-    auto* buf_stream_spec = new CBufInStream;
-    CMyComPtr< IInStream > buf_stream( buf_stream_spec );
-    buf_stream_spec->Init( &in_buffer[0], in_buffer.size() );
-
-    auto* open_callback_spec = new OpenCallback( opener );
-
-    CMyComPtr< IArchiveOpenCallback > open_callback( open_callback_spec );
-    if ( in_archive->Open( buf_stream, nullptr, open_callback ) != S_OK ) {
-        throw BitException( "Cannot open archive buffer" );
-    }
-    return in_archive;
-}
 
 BitMemExtractor::BitMemExtractor( const Bit7zLibrary& lib, const BitInFormat& format )
     : BitArchiveOpener( lib, format ) {}
 
 void BitMemExtractor::extract( const vector< byte_t >& in_buffer, const wstring& out_dir ) const {
     CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
-
-    auto* extract_callback_spec = new ExtractCallback( *this, in_archive, L"", out_dir );
-
-    CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
-    if ( in_archive->Extract( nullptr, static_cast< uint32_t >( -1 ), NExtract::NAskMode::kExtract, extract_callback ) != S_OK ) {
-        throw BitException( extract_callback_spec->getErrorMessage() );
-    }
+    extractToFileSystem( in_archive, *this, L"", out_dir, vector< uint32_t >() );
 }
 
 void BitMemExtractor::extract( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
                                unsigned int index ) const {
     CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
+    extractToBuffer( in_archive, *this, out_buffer, index );
+}
 
-    uint32_t number_items;
-    in_archive->GetNumberOfItems( &number_items );
-    if ( index >= number_items ) {
-        throw BitException( "Index " + std::to_string( index ) + " is out of range"  );
-    }
-
-    auto* extract_callback_spec = new MemExtractCallback( *this, in_archive, out_buffer );
+void BitMemExtractor::extract( const vector< byte_t >& in_buffer, BitChunkedBuffer& out_buffer,
+                               unsigned int index ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
+    extractToBuffer( in_archive, *this, out_buffer, index );
+}
 
-    const uint32_t indices[] = { index };
+void BitMemExtractor::extractItems( const vector< byte_t >& in_buffer, const vector< uint32_t >& indices,
+                                    BitItemsBuffer& out_items ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
+    extractToItemsBuffer( in_archive, *this, indices, out_items );
+}
 
-    CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
-    if ( in_archive->Extract( indices, 1, NExtract::NAskMode::kExtract, extract_callback ) != S_OK ) {
-        throw BitException( extract_callback_spec->getErrorMessage() );
+void BitMemExtractor::extractMatching( const vector< byte_t >& in_buffer, const ItemPredicate& predicate,
+                                       BitItemsBuffer& out_items ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
+    vector< uint32_t > matched_indices = matchingIndices( in_archive, predicate );
+    if ( matched_indices.empty() ) {
+        out_items.clear();
+        return;
     }
+    extractToItemsBuffer( in_archive, *this, matched_indices, out_items );
+}
+
+void BitMemExtractor::extractToSinks( const vector< byte_t >& in_buffer, const SinkFactory& sink_factory,
+                                      const vector< uint32_t >& indices ) const {
+    CMyComPtr< IInArchive > in_archive = openArchive( mLibrary, mFormat, in_buffer, *this );
+    util::extractToSinks( in_archive, *this, sink_factory, indices );
+}
+
+void BitMemExtractor::extractMembers( const vector< byte_t >& in_buffer, vector< byte_t >& out_buffer,
+                                      uint32_t threads_count ) const {
+    out_buffer.clear();
+    auto* out_mem_stream_spec = new COutMemStream( out_buffer );
+    CMyComPtr< ISequentialOutStream > out_mem_stream( out_mem_stream_spec );
+    util::extractMembers( mLibrary, mFormat, *this, in_buffer.size(), bufferChunkReader( in_buffer ),
+                          bufferRangeOpener( in_buffer ), threads_count, out_mem_stream );
 }
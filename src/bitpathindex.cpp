@@ -0,0 +1,188 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/bitpathindex.hpp"
+
+#include "../include/bitarchiveinfo.hpp"
+#include "../include/fsutil.hpp"
+
+using namespace bit7z;
+using namespace bit7z::filesystem;
+
+const uint32_t kNoItem = static_cast< uint32_t >( -1 );
+const uint32_t kRootNode = 0;
+
+namespace {
+    inline uint64_t edgeKey( uint32_t parent, uint32_t name ) {
+        return ( static_cast< uint64_t >( parent ) << 32 ) | name;
+    }
+
+    inline bool isSeparator( wchar_t c ) {
+        return c == L'\\' || c == L'/';
+    }
+
+    // Calls the given function for each (non-empty) component of the path, stopping when it returns false
+    template< typename F >
+    bool forEachComponent( const wstring& path, F function ) {
+        size_t start = 0;
+        while ( start < path.size() ) {
+            size_t end = start;
+            while ( end < path.size() && !isSeparator( path[ end ] ) ) {
+                ++end;
+            }
+            if ( end > start && !function( path.substr( start, end - start ) ) ) {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+}
+
+BitPathIndex::BitPathIndex( const BitArchiveInfo& archive ) {
+    Node root = { internName( L"" ), kNoItem, vector< uint32_t >() };
+    mNodes.push_back( root );
+
+    uint32_t items_count = archive.itemsCount();
+    for ( uint32_t index = 0; index < items_count; ++index ) {
+        BitPropVariant path = archive.getItemProperty( index, BitProperty::Path );
+        if ( !path.isString() ) {
+            continue;
+        }
+        uint32_t node = kRootNode;
+        forEachComponent( path.getString(), [ this, &node ]( const wstring& component ) {
+            node = addNode( node, internName( component ) );
+            return true;
+        } );
+        if ( node != kRootNode ) {
+            mNodes[ node ].itemIndex = index; // if an archive contains the same path many times, the last item wins
+        }
+    }
+}
+
+uint32_t BitPathIndex::internName( const wstring& name ) {
+    auto it = mNamesIds.find( name );
+    if ( it != mNamesIds.end() ) {
+        return it->second;
+    }
+    auto name_id = static_cast< uint32_t >( mNames.size() );
+    mNames.push_back( name );
+    mNamesIds[ name ] = name_id;
+    mFoldedNames.push_back( name_id );
+
+    wstring folded_name = fsutil::fold_case( name );
+    if ( folded_name != name ) {
+        uint32_t folded_id = internName( folded_name ); // folding a folded name does not change it: no deep recursion
+        mFoldedNames[ name_id ] = folded_id;
+    }
+    return name_id;
+}
+
+uint32_t BitPathIndex::addNode( uint32_t parent, uint32_t name ) {
+    auto it = mChildren.find( edgeKey( parent, name ) );
+    if ( it != mChildren.end() ) {
+        return it->second;
+    }
+    auto node = static_cast< uint32_t >( mNodes.size() );
+    Node child = { name, kNoItem, vector< uint32_t >() };
+    mNodes.push_back( child );
+    mNodes[ parent ].children.push_back( node );
+    mChildren[ edgeKey( parent, name ) ] = node;
+    // When many names differ only by their case, case-insensitive lookups find the first one
+    mFoldedChildren.insert( std::make_pair( edgeKey( parent, mFoldedNames[ name ] ), node ) );
+    return node;
+}
+
+bool BitPathIndex::findName( const wstring& name, uint32_t& name_id ) const {
+    auto it = mNamesIds.find( name );
+    if ( it == mNamesIds.end() ) {
+        return false;
+    }
+    name_id = it->second;
+    return true;
+}
+
+bool BitPathIndex::findNode( const wstring& path, bool case_sensitive, uint32_t& node ) const {
+    const std::unordered_map< uint64_t, uint32_t >& children = case_sensitive ? mChildren : mFoldedChildren;
+    uint32_t current = kRootNode;
+    bool found = forEachComponent( path, [ & ]( const wstring& component ) {
+        uint32_t name_id;
+        if ( !findName( case_sensitive ? component : fsutil::fold_case( component ), name_id ) ) {
+            return false;
+        }
+        auto it = children.find( edgeKey( current, name_id ) );
+        if ( it == children.end() ) {
+            return false;
+        }
+        current = it->second;
+        return true;
+    } );
+    if ( found ) {
+        node = current;
+    }
+    return found;
+}
+
+bool BitPathIndex::find( const wstring& path, uint32_t& index, bool case_sensitive ) const {
+    uint32_t node;
+    if ( !findNode( path, case_sensitive, node ) || mNodes[ node ].itemIndex == kNoItem ) {
+        return false;
+    }
+    index = mNodes[ node ].itemIndex;
+    return true;
+}
+
+bool BitPathIndex::isDirectory( const wstring& path, bool case_sensitive ) const {
+    uint32_t node;
+    return findNode( path, case_sensitive, node ) && !mNodes[ node ].children.empty();
+}
+
+vector< wstring > BitPathIndex::directoryNames( const wstring& dir_path, bool case_sensitive ) const {
+    vector< wstring > result;
+    uint32_t node;
+    if ( findNode( dir_path, case_sensitive, node ) ) {
+        result.reserve( mNodes[ node ].children.size() );
+        for ( uint32_t child : mNodes[ node ].children ) {
+            result.push_back( mNames[ mNodes[ child ].name ] );
+        }
+    }
+    return result;
+}
+
+vector< uint32_t > BitPathIndex::directoryItems( const wstring& dir_path, bool recursive, bool case_sensitive ) const {
+    vector< uint32_t > result;
+    uint32_t node;
+    if ( !findNode( dir_path, case_sensitive, node ) ) {
+        return result;
+    }
+    vector< uint32_t > pending( mNodes[ node ].children.rbegin(), mNodes[ node ].children.rend() );
+    while ( !pending.empty() ) {
+        const Node& current = mNodes[ pending.back() ];
+        pending.pop_back();
+        if ( current.itemIndex != kNoItem ) {
+            result.push_back( current.itemIndex );
+        }
+        if ( recursive ) {
+            pending.insert( pending.end(), current.children.rbegin(), current.children.rend() );
+        }
+    }
+    return result;
+}
@@ -243,6 +243,20 @@ wstring BitPropVariant::getString() const {
     return bstrVal == nullptr ? L"" : wstring( bstrVal, SysStringLen( bstrVal ) );
 }
 
+const wchar_t* BitPropVariant::getStringData() const {
+    if ( vt != VT_BSTR ) {
+        throw BitException( "BitPropVariant is not a string" );
+    }
+    return bstrVal == nullptr ? L"" : bstrVal;
+}
+
+size_t BitPropVariant::getStringLength() const {
+    if ( vt != VT_BSTR ) {
+        throw BitException( "BitPropVariant is not a string" );
+    }
+    return bstrVal == nullptr ? 0 : SysStringLen( bstrVal ); // O(1): the length is stored in the BSTR prefix
+}
+
 uint8_t BitPropVariant::getUInt8() const {
     switch ( vt ) {
         case VT_UI1:
@@ -446,6 +460,14 @@ void BitPropVariant::clear() {
     vt = VT_EMPTY;
 }
 
+void BitPropVariant::detach( PROPVARIANT* destination ) NOEXCEPT {
+    /* Copying the whole PROPVARIANT copies only the pointer to the string (if any): setting this variant as empty
+     * prevents the string, which now belongs to destination, from being freed when this variant is destroyed. */
+    *destination = *this;
+    vt = VT_EMPTY;
+    bstrVal = nullptr;
+}
+
 void BitPropVariant::internalClear() {
     if ( vt == VT_BSTR && bstrVal != nullptr ) {
         ::SysFreeString( bstrVal ); //this was a string: since it is not needed anymore, we must free it!
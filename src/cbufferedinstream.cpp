@@ -0,0 +1,69 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/cbufferedinstream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace bit7z;
+
+CBufferedInStream::CBufferedInStream( uint32_t buffer_size )
+    : mFile( INVALID_HANDLE_VALUE ), mBuffer( buffer_size ), mBufferPosition( 0 ), mBufferEnd( 0 ) {}
+
+CBufferedInStream::~CBufferedInStream() {
+    if ( mFile != INVALID_HANDLE_VALUE ) {
+        CloseHandle( mFile );
+    }
+}
+
+bool CBufferedInStream::Open( const wstring& path ) {
+    mFile = CreateFile( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    return mFile != INVALID_HANDLE_VALUE;
+}
+
+STDMETHODIMP CBufferedInStream::Read( void* data, UInt32 size, UInt32* processedSize ) {
+    if ( processedSize != nullptr ) {
+        *processedSize = 0;
+    }
+    if ( size == 0 ) {
+        return S_OK;
+    }
+    if ( mBufferPosition == mBufferEnd ) {
+        DWORD read_size = 0;
+        if ( !ReadFile( mFile, mBuffer.data(), static_cast< DWORD >( mBuffer.size() ), &read_size, nullptr ) ) {
+            DWORD error = GetLastError();
+            return error == ERROR_BROKEN_PIPE ? S_OK : HRESULT_FROM_WIN32( error ); // a closed pipe is the end
+        }
+        mBufferPosition = 0;
+        mBufferEnd = read_size;
+    }
+    // Returning less than requested is allowed for sequential streams: the encoder will ask for the rest
+    auto count = static_cast< UInt32 >( std::min< size_t >( size, mBufferEnd - mBufferPosition ) );
+    std::memcpy( data, mBuffer.data() + mBufferPosition, count );
+    mBufferPosition += count;
+    if ( processedSize != nullptr ) {
+        *processedSize = count;
+    }
+    return S_OK;
+}
@@ -0,0 +1,266 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/cmappedinstream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace bit7z;
+
+namespace {
+    // The offsets of the views of a file mapping must be multiples of the allocation granularity (64 KiB on Windows)
+    const uint64_t kViewAlignment = 1u << 16;
+    // Views size limit used by default: on 32-bit systems, the whole file is mapped only if it is not too big
+    const uint64_t kDefaultMaxViewSize = sizeof( void* ) >= 8 ? UINT64_MAX : 256u * 1024 * 1024;
+    // Amount of data prefetched ahead of the read position in sequential mode
+    const uint64_t kPrefetchSize = 4u * 1024 * 1024;
+
+    /* PrefetchVirtualMemory is available only since Windows 8, hence it is loaded at runtime (and the structure
+     * describing the memory ranges is declared here, since older SDKs do not define it). */
+    struct MemoryRangeEntry {
+        void* virtualAddress;
+        SIZE_T numberOfBytes;
+    };
+
+    typedef BOOL ( WINAPI* PrefetchVirtualMemoryFunc )( HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG );
+
+    /* Copies data from a mapped view: if the pages cannot be read (e.g. a network share has been disconnected or the
+     * disk has a bad sector), the system raises an EXCEPTION_IN_PAGE_ERROR structured exception instead of returning
+     * an error, which must be handled here (in a function without objects to be unwound) not to crash the process. */
+    bool copyFromView( void* destination, const void* source, size_t size ) {
+#ifdef _MSC_VER
+        __try {
+            std::memcpy( destination, source, size );
+        } __except ( GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+                     EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH ) {
+            return false;
+        }
+#else
+        std::memcpy( destination, source, size );
+#endif
+        return true;
+    }
+
+    PrefetchVirtualMemoryFunc prefetchVirtualMemory() {
+        static const auto prefetch_func = reinterpret_cast< PrefetchVirtualMemoryFunc >(
+            GetProcAddress( GetModuleHandle( L"kernel32.dll" ), "PrefetchVirtualMemory" ) );
+        return prefetch_func;
+    }
+}
+
+CMappedInStream::CMappedInStream()
+    : mFile( INVALID_HANDLE_VALUE ),
+      mMapping( nullptr ),
+      mView( nullptr ),
+      mViewOffset( 0 ),
+      mViewSize( 0 ),
+      mMaxViewSize( kDefaultMaxViewSize ),
+      mSize( 0 ),
+      mPosition( 0 ),
+      mPrefetchedEnd( 0 ),
+      mDroppedEnd( 0 ),
+      mSequentialAccess( false ),
+      mDropBehind( false ) {}
+
+CMappedInStream::~CMappedInStream() {
+    close();
+}
+
+bool CMappedInStream::Open( const wstring& path, bool sequential_access, uint64_t max_view_size,
+                            bool drop_behind ) {
+    close();
+    mSequentialAccess = sequential_access;
+    mDropBehind = drop_behind;
+    mFile = CreateFile( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        sequential_access ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr );
+    if ( mFile == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+    if ( GetFileType( mFile ) != FILE_TYPE_DISK ) { // e.g. pipes and devices, which cannot be mapped
+        close();
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if ( !GetFileSizeEx( mFile, &file_size ) ) {
+        close();
+        return false;
+    }
+    mSize = static_cast< uint64_t >( file_size.QuadPart );
+    if ( mSize == 0 ) { // empty files cannot be mapped, but they do not need to be
+        return true;
+    }
+    mMapping = CreateFileMapping( mFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( mMapping == nullptr ) {
+        close();
+        return false;
+    }
+
+    if ( max_view_size == 0 ) {
+        max_view_size = kDefaultMaxViewSize;
+    }
+    // If the file does not fit a single view, the view size must be a multiple of the allocation granularity
+    mMaxViewSize = mSize <= max_view_size ? mSize : std::max( max_view_size - max_view_size % kViewAlignment,
+                                                              kViewAlignment );
+    if ( !mapView( 0 ) ) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool CMappedInStream::mapView( uint64_t offset ) {
+    unmapView();
+    mViewOffset = offset - offset % kViewAlignment;
+    mViewSize = std::min( mMaxViewSize, mSize - mViewOffset );
+    mView = static_cast< const byte_t* >( MapViewOfFile( mMapping, FILE_MAP_READ,
+                                                         static_cast< DWORD >( mViewOffset >> 32 ),
+                                                         static_cast< DWORD >( mViewOffset & 0xFFFFFFFF ),
+                                                         static_cast< SIZE_T >( mViewSize ) ) );
+    if ( mView == nullptr ) {
+        mViewSize = 0;
+        return false;
+    }
+    mPrefetchedEnd = mViewOffset;
+    mDroppedEnd = mViewOffset;
+    return true;
+}
+
+void CMappedInStream::unmapView() {
+    if ( mView != nullptr ) {
+        UnmapViewOfFile( mView );
+        mView = nullptr;
+    }
+    mViewSize = 0;
+}
+
+void CMappedInStream::prefetch() {
+    /* The next pages are prefetched when the read position gets within half the prefetch size from the end of the
+     * range already prefetched, so that the system reads them while the current ones are being consumed. */
+    const uint64_t view_end = mViewOffset + mViewSize;
+    if ( mPrefetchedEnd >= view_end || mPosition + kPrefetchSize / 2 < mPrefetchedEnd ) {
+        return;
+    }
+    PrefetchVirtualMemoryFunc prefetch_func = prefetchVirtualMemory();
+    if ( prefetch_func == nullptr ) {
+        return;
+    }
+    const uint64_t range_start = std::max( mPrefetchedEnd, mPosition );
+    const uint64_t range_end = std::min( range_start + kPrefetchSize, view_end );
+    MemoryRangeEntry range;
+    range.virtualAddress = const_cast< byte_t* >( mView + ( range_start - mViewOffset ) );
+    range.numberOfBytes = static_cast< SIZE_T >( range_end - range_start );
+    prefetch_func( GetCurrentProcess(), 1, &range, 0 );
+    mPrefetchedEnd = range_end;
+}
+
+void CMappedInStream::dropBehind() {
+    /* Unlocking pages which are not locked removes them from the working set of the process: the consumed pages are
+     * trimmed in blocks of the prefetch size. Note: this is not the equivalent of POSIX_FADV_DONTNEED, since the pages
+     * stay in the system file cache (as standby pages) and are evicted from it by the memory manager as usual. */
+    if ( mPosition < mDroppedEnd + kPrefetchSize ) {
+        return;
+    }
+    const uint64_t range_end = mPosition - mPosition % kViewAlignment;
+    VirtualUnlock( const_cast< byte_t* >( mView + ( mDroppedEnd - mViewOffset ) ),
+                   static_cast< SIZE_T >( range_end - mDroppedEnd ) );
+    mDroppedEnd = range_end;
+}
+
+void CMappedInStream::close() {
+    unmapView();
+    if ( mMapping != nullptr ) {
+        CloseHandle( mMapping );
+        mMapping = nullptr;
+    }
+    if ( mFile != INVALID_HANDLE_VALUE ) {
+        CloseHandle( mFile );
+        mFile = INVALID_HANDLE_VALUE;
+    }
+    mSize = 0;
+    mPosition = 0;
+}
+
+STDMETHODIMP CMappedInStream::Read( void* data, UInt32 size, UInt32* processedSize ) {
+    if ( processedSize != nullptr ) {
+        *processedSize = 0;
+    }
+    if ( mPosition >= mSize ) {
+        return S_OK;
+    }
+    auto* out_data = static_cast< byte_t* >( data );
+    UInt32 remaining = static_cast< UInt32 >( std::min< uint64_t >( size, mSize - mPosition ) );
+    while ( remaining > 0 ) {
+        if ( mPosition < mViewOffset || mPosition >= mViewOffset + mViewSize ) {
+            if ( !mapView( mPosition ) ) {
+                return HRESULT_FROM_WIN32( GetLastError() );
+            }
+        }
+        if ( mSequentialAccess ) {
+            prefetch();
+        }
+        auto count = static_cast< UInt32 >( std::min< uint64_t >( remaining, mViewOffset + mViewSize - mPosition ) );
+        if ( !copyFromView( out_data, mView + ( mPosition - mViewOffset ), count ) ) {
+            return HRESULT_FROM_WIN32( ERROR_READ_FAULT );
+        }
+        out_data += count;
+        remaining -= count;
+        mPosition += count;
+        if ( processedSize != nullptr ) {
+            *processedSize += count;
+        }
+        if ( mDropBehind ) {
+            dropBehind();
+        }
+    }
+    return S_OK;
+}
+
+STDMETHODIMP CMappedInStream::Seek( Int64 offset, UInt32 seekOrigin, UInt64* newPosition ) {
+    Int64 base;
+    switch ( seekOrigin ) {
+        case STREAM_SEEK_SET:
+            base = 0;
+            break;
+        case STREAM_SEEK_CUR:
+            base = static_cast< Int64 >( mPosition );
+            break;
+        case STREAM_SEEK_END:
+            base = static_cast< Int64 >( mSize );
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+    if ( base + offset < 0 ) {
+        return STG_E_INVALIDFUNCTION;
+    }
+    mPosition = static_cast< uint64_t >( base + offset );
+    if ( newPosition != nullptr ) {
+        *newPosition = mPosition;
+    }
+    return S_OK;
+}
+
+STDMETHODIMP CMappedInStream::GetSize( UInt64* size ) {
+    *size = mSize;
+    return S_OK;
+}
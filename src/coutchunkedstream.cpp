@@ -0,0 +1,78 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/coutchunkedstream.hpp"
+
+using namespace bit7z;
+
+COutChunkedStream::COutChunkedStream( BitChunkedBuffer& out_buffer )
+    : mBuffer( out_buffer ), mOrigin( out_buffer.size() ), mPosition( out_buffer.size() ) {}
+
+COutChunkedStream::~COutChunkedStream() {}
+
+STDMETHODIMP COutChunkedStream::Write( const void* data, UInt32 size, UInt32* processedSize ) {
+    if ( processedSize != nullptr ) {
+        *processedSize = 0;
+    }
+    if ( size == 0 ) {
+        return S_OK;
+    }
+    if ( data == nullptr ) {
+        return E_FAIL;
+    }
+    mBuffer.write( mPosition, static_cast< const byte_t* >( data ), size );
+    mPosition += size;
+    if ( processedSize != nullptr ) {
+        *processedSize = size;
+    }
+    return S_OK;
+}
+
+STDMETHODIMP COutChunkedStream::Seek( Int64 offset, UInt32 seekOrigin, UInt64* newPosition ) {
+    Int64 base;
+    switch ( seekOrigin ) {
+        case STREAM_SEEK_SET:
+            base = 0;
+            break;
+        case STREAM_SEEK_CUR:
+            base = static_cast< Int64 >( mPosition - mOrigin );
+            break;
+        case STREAM_SEEK_END:
+            base = static_cast< Int64 >( mBuffer.size() - mOrigin );
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+    if ( base + offset < 0 ) {
+        return STG_E_INVALIDFUNCTION;
+    }
+    mPosition = mOrigin + static_cast< size_t >( base + offset );
+    if ( newPosition != nullptr ) {
+        *newPosition = mPosition - mOrigin;
+    }
+    return S_OK;
+}
+
+STDMETHODIMP COutChunkedStream::SetSize( UInt64 newSize ) {
+    mBuffer.resize( mOrigin + static_cast< size_t >( newSize ) );
+    return S_OK;
+}
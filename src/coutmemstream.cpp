@@ -27,7 +27,8 @@
 
 using namespace bit7z;
 
-COutMemStream::COutMemStream( vector< byte_t >& out_buffer ) : mBuffer( out_buffer ) {}
+COutMemStream::COutMemStream( vector< byte_t >& out_buffer )
+    : mBuffer( out_buffer ), mOrigin( out_buffer.size() ), mPosition( out_buffer.size() ) {}
 
 COutMemStream::~COutMemStream() {};
 
@@ -35,13 +36,53 @@ STDMETHODIMP COutMemStream::Write( const void* data, UInt32 size, UInt32* proces
     if ( processedSize != nullptr ) {
         *processedSize = 0;
     }
-    if ( data == nullptr || size == 0 ) {
+    if ( size == 0 ) {
+        return S_OK;
+    }
+    if ( data == nullptr ) {
         return E_FAIL;
     }
     const auto* byte_data = static_cast< const byte_t* >( data );
-    mBuffer.insert( mBuffer.end(), byte_data, byte_data + size );
+    if ( mPosition > mBuffer.size() ) { // the stream has been moved past its end: the gap is filled with zeros
+        mBuffer.resize( mPosition );
+    }
+    // Overwriting the content after the current position (if any), and appending the remaining data
+    size_t overwritten = std::min< size_t >( size, mBuffer.size() - mPosition );
+    std::copy( byte_data, byte_data + overwritten, mBuffer.begin() + mPosition );
+    mBuffer.insert( mBuffer.end(), byte_data + overwritten, byte_data + size );
+    mPosition += size;
     if ( processedSize != nullptr ) {
         *processedSize = size;
     }
     return S_OK;
 }
+
+STDMETHODIMP COutMemStream::Seek( Int64 offset, UInt32 seekOrigin, UInt64* newPosition ) {
+    Int64 base;
+    switch ( seekOrigin ) {
+        case STREAM_SEEK_SET:
+            base = 0;
+            break;
+        case STREAM_SEEK_CUR:
+            base = static_cast< Int64 >( mPosition - mOrigin );
+            break;
+        case STREAM_SEEK_END:
+            base = static_cast< Int64 >( mBuffer.size() - mOrigin );
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+    if ( base + offset < 0 ) {
+        return STG_E_INVALIDFUNCTION;
+    }
+    mPosition = mOrigin + static_cast< size_t >( base + offset );
+    if ( newPosition != nullptr ) {
+        *newPosition = mPosition - mOrigin;
+    }
+    return S_OK;
+}
+
+STDMETHODIMP COutMemStream::SetSize( UInt64 newSize ) {
+    mBuffer.resize( mOrigin + static_cast< size_t >( newSize ) );
+    return S_OK;
+}
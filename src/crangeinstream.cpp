@@ -0,0 +1,79 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/crangeinstream.hpp"
+
+#include <algorithm>
+
+using namespace bit7z;
+
+CRangeInStream::CRangeInStream( IInStream* in_stream, uint64_t begin, uint64_t size )
+    : mStream( in_stream ), mBegin( begin ), mSize( size ), mPosition( 0 ), mStreamPosition( UINT64_MAX ) {}
+
+CRangeInStream::~CRangeInStream() {}
+
+STDMETHODIMP CRangeInStream::Read( void* data, UInt32 size, UInt32* processedSize ) {
+    if ( processedSize != nullptr ) {
+        *processedSize = 0;
+    }
+    if ( mPosition >= mSize ) {
+        return S_OK;
+    }
+    size = static_cast< UInt32 >( std::min< uint64_t >( size, mSize - mPosition ) );
+    if ( mStreamPosition != mPosition ) {
+        RINOK( mStream->Seek( static_cast< Int64 >( mBegin + mPosition ), STREAM_SEEK_SET, nullptr ) );
+        mStreamPosition = mPosition;
+    }
+    UInt32 read_size = 0;
+    HRESULT res = mStream->Read( data, size, &read_size );
+    mPosition += read_size;
+    mStreamPosition = mPosition;
+    if ( processedSize != nullptr ) {
+        *processedSize = read_size;
+    }
+    return res;
+}
+
+STDMETHODIMP CRangeInStream::Seek( Int64 offset, UInt32 seekOrigin, UInt64* newPosition ) {
+    Int64 base;
+    switch ( seekOrigin ) {
+        case STREAM_SEEK_SET:
+            base = 0;
+            break;
+        case STREAM_SEEK_CUR:
+            base = static_cast< Int64 >( mPosition );
+            break;
+        case STREAM_SEEK_END:
+            base = static_cast< Int64 >( mSize );
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+    if ( base + offset < 0 ) {
+        return STG_E_INVALIDFUNCTION;
+    }
+    mPosition = static_cast< uint64_t >( base + offset );
+    if ( newPosition != nullptr ) {
+        *newPosition = mPosition;
+    }
+    return S_OK;
+}
@@ -54,6 +54,9 @@ static const wstring kDataError         = L"Data Error";
 static const wstring kUnknownError      = L"Unknown Error";
 static const wstring kEmptyFileAlias    = L"[Content]";
 
+// Output files smaller than this size are not preallocated, since they are unlikely to be fragmented anyway
+static const UInt64 kPreallocationThreshold = 1024 * 1024;
+
 ExtractCallback::ExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler,
                                   const wstring& inFilePath, const wstring& directoryPath ) :
     mOpener( opener ),
@@ -63,6 +66,7 @@ ExtractCallback::ExtractCallback( const BitArchiveOpener& opener, IInArchive* ar
     mExtractMode( true ),
     mProcessedFileInfo(),
     mOutFileStreamSpec( nullptr ),
+    mPreallocatedSize( 0 ),
     mNumErrors( 0 ) {
     //NFile::NName::NormalizeDirPathPrefix( mDirectoryPath );
     filesystem::fsutil::normalize_path( mDirectoryPath );
@@ -183,6 +187,17 @@ STDMETHODIMP ExtractCallback::GetStream( UInt32                 index,
             return E_ABORT;
         }
 
+        /* If the size of the item is known, the whole output file is allocated in advance, so that the file system
+         * can place it contiguously instead of extending it write after write (the file is then truncated to the
+         * size actually written, see SetOperationResult). */
+        mPreallocatedSize = 0;
+        BitPropVariant size_prop;
+        if ( mArchiveHandler->GetProperty( index, kpidSize, &size_prop ) == S_OK && size_prop.isUInt64() &&
+             size_prop.getUInt64() >= kPreallocationThreshold &&
+             mOutFileStreamSpec->SetSize( size_prop.getUInt64() ) == S_OK ) {
+            mPreallocatedSize = size_prop.getUInt64();
+        }
+
         mOutFileStream = outStreamLoc;
         *outStream = outStreamLoc.Detach();
     }
@@ -244,6 +259,12 @@ STDMETHODIMP ExtractCallback::SetOperationResult( Int32 operationResult ) {
     }
 
     if ( mOutFileStream != nullptr ) {
+        if ( mPreallocatedSize > 0 && mOutFileStreamSpec->ProcessedSize != mPreallocatedSize ) {
+            // e.g. the item size was wrong or the extraction failed: the unwritten preallocated space is dropped
+            mOutFileStreamSpec->SetSize( mOutFileStreamSpec->ProcessedSize );
+        }
+        mPreallocatedSize = 0;
+
         if ( mProcessedFileInfo.MTimeDefined ) {
             mOutFileStreamSpec->SetMTime( &mProcessedFileInfo.MTime );
         }
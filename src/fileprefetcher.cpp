@@ -0,0 +1,190 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/fileprefetcher.hpp"
+
+#include <algorithm>
+
+#include "7zip/Common/FileStreams.h"
+
+using namespace bit7z;
+
+namespace {
+    const uint32_t kMaxPrefetchThreads = 8;
+}
+
+FilePrefetcher::FilePrefetcher( const vector< FSItem >& items, uint32_t window_size, uint64_t memory_limit )
+    : mItems( items ), mWindowSize( window_size ), mMemoryLimit( memory_limit ), mMemoryUsed( 0 ), mStopping( false ) {
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        moveWindow( 0 );
+    }
+    uint32_t threads_count = std::min( window_size, kMaxPrefetchThreads );
+    for ( uint32_t i = 0; i < threads_count; ++i ) {
+        mWorkers.emplace_back( &FilePrefetcher::workerLoop, this );
+    }
+}
+
+FilePrefetcher::~FilePrefetcher() {
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for ( auto& worker : mWorkers ) {
+        worker.join();
+    }
+}
+
+CMyComPtr< ISequentialInStream > FilePrefetcher::takeStream( uint32_t index ) {
+    CMyComPtr< ISequentialInStream > result;
+    std::unique_lock< std::mutex > lock( mMutex );
+    /* A file being read is waited for, while a file not read yet is better opened directly by the caller.
+     * Note: the entry is looked up again after each wakeup, since a discarded entry is erased by its worker. */
+    auto waited = [ this, index ]() {
+        auto entry_it = mEntries.find( index );
+        return entry_it == mEntries.end() || entry_it->second.discarded ||
+               entry_it->second.state != EntryState::Reading;
+    };
+    mEntryDone.wait( lock, waited );
+    auto entry_it = mEntries.find( index );
+    // a discarded entry is still owned by its worker (if being read), hence the file is opened directly by the caller
+    if ( entry_it != mEntries.end() && !entry_it->second.discarded ) {
+        Entry& entry = entry_it->second;
+        if ( entry.state == EntryState::Ready ) {
+            auto* buf_stream_spec = new CBufInStream;
+            result = buf_stream_spec;
+            buf_stream_spec->Init( entry.buffer );
+        }
+        if ( entry.state == EntryState::Queued || entry.state == EntryState::Ready ) {
+            mMemoryUsed -= entry.size;
+        }
+        mEntries.erase( entry_it );
+    }
+    moveWindow( index + 1 );
+    lock.unlock();
+    mWorkAvailable.notify_all();
+    return result;
+}
+
+// Note: it must be called with mMutex locked
+void FilePrefetcher::moveWindow( uint32_t first_index ) {
+    const uint64_t last_index = std::min< uint64_t >( static_cast< uint64_t >( first_index ) + mWindowSize,
+                                                      mItems.size() );
+
+    // Dropping the entries outside the new window (the ones being read are dropped by their worker)
+    for ( auto entry_it = mEntries.begin(); entry_it != mEntries.end(); ) {
+        Entry& entry = entry_it->second;
+        if ( entry_it->first >= first_index && entry_it->first < last_index ) {
+            ++entry_it;
+        } else if ( entry.state == EntryState::Reading ) {
+            entry.discarded = true;
+            ++entry_it;
+        } else {
+            if ( entry.state != EntryState::Failed ) {
+                mMemoryUsed -= entry.size;
+            }
+            entry_it = mEntries.erase( entry_it );
+        }
+    }
+
+    /* Scheduling the files of the window in order, until the memory limit is reached; the files that could never fit
+     * the limit are skipped (they are read as usual by the encoder), so that they do not stop the read-ahead. */
+    for ( uint64_t index = first_index; index < last_index; ++index ) {
+        auto item_index = static_cast< uint32_t >( index );
+        const FSItem& item = mItems[ item_index ];
+        if ( item.isDir() || item.size() > mMemoryLimit || mEntries.count( item_index ) > 0 ) {
+            continue;
+        }
+        if ( mMemoryUsed + item.size() > mMemoryLimit ) {
+            break;
+        }
+        Entry entry = { EntryState::Queued, false, item.size(), CMyComPtr< CReferenceBuf >() };
+        mEntries[ item_index ] = entry;
+        mMemoryUsed += item.size();
+        mQueue.push_back( item_index );
+    }
+}
+
+void FilePrefetcher::workerLoop() {
+    std::unique_lock< std::mutex > lock( mMutex );
+    while ( true ) {
+        mWorkAvailable.wait( lock, [ this ]() { return mStopping || !mQueue.empty(); } );
+        if ( mStopping ) {
+            return;
+        }
+        uint32_t index = mQueue.front();
+        mQueue.pop_front();
+        auto entry_it = mEntries.find( index );
+        if ( entry_it == mEntries.end() || entry_it->second.state != EntryState::Queued ) {
+            continue; // the entry has been dropped or taken in the meantime
+        }
+        entry_it->second.state = EntryState::Reading;
+        /* The buffer is referenced only by the entry, and it is created while holding the lock, since the reference
+         * counting of 7-zip objects is not atomic (the entry is not erased by the other threads while being read). */
+        entry_it->second.buffer = new CReferenceBuf;
+        CReferenceBuf* buffer = entry_it->second.buffer;
+
+        lock.unlock();
+        bool succeeded = readFile( mItems[ index ], buffer );
+        lock.lock();
+
+        entry_it = mEntries.find( index );
+        Entry& entry = entry_it->second;
+        if ( entry.discarded || !succeeded ) {
+            mMemoryUsed -= entry.size;
+        }
+        if ( entry.discarded ) {
+            mEntries.erase( entry_it );
+        } else {
+            entry.state = succeeded ? EntryState::Ready : EntryState::Failed;
+            if ( !succeeded ) {
+                entry.buffer.Release();
+            }
+        }
+        mEntryDone.notify_all();
+    }
+}
+
+bool FilePrefetcher::readFile( const FSItem& item, CReferenceBuf* buffer ) {
+    auto* in_file_stream_spec = new CInFileStream;
+    CMyComPtr< IInStream > in_file_stream( in_file_stream_spec );
+    if ( !in_file_stream_spec->Open( item.path().c_str() ) ) {
+        return false;
+    }
+    auto size = static_cast< size_t >( item.size() );
+    buffer->Buf.Alloc( size );
+    size_t read_size = 0;
+    while ( read_size < size ) {
+        UInt32 processed_size = 0;
+        auto chunk_size = static_cast< UInt32 >( std::min< size_t >( size - read_size, 1u << 30 ) );
+        if ( in_file_stream->Read( buffer->Buf + read_size, chunk_size, &processed_size ) != S_OK ||
+                processed_size == 0 ) {
+            return false; // the file has been truncated (or it is not readable)
+        }
+        read_size += processed_size;
+    }
+    // if the file has grown since it was indexed, it must be read directly
+    Byte extra_byte;
+    UInt32 processed_size = 0;
+    return in_file_stream->Read( &extra_byte, 1, &processed_size ) == S_OK && processed_size == 0;
+}
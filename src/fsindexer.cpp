@@ -29,7 +29,8 @@
 using std::wstring;
 using namespace bit7z::filesystem;
 
-FSIndexer::FSIndexer( const wstring& directory, const wstring& filter ) : mDirItem( directory ), mFilter( filter ) {
+FSIndexer::FSIndexer( const wstring& directory, const wstring& filter ) : mDirItem( directory ), mFilter( filter ),
+    mMatcher( filter ) {
     if ( !mDirItem.isDir() ) {
         throw BitException( L"'" + mDirItem.name() + L"' is not a directory!" );
     }
@@ -63,7 +64,7 @@ void FSIndexer::listDirectoryItems( vector< FSItem >& result, bool recursive, co
             continue;
         }
 
-        bool item_matches = fsutil::wildcard_match( mFilter, current_item.name() );
+        bool item_matches = mMatcher.matches( current_item.name() );
         if ( item_matches ) {
             result.push_back( current_item );
         }
@@ -23,6 +23,9 @@
 
 #include "../include/bitexception.hpp"
 
+#include <algorithm>
+#include <cwctype>
+
 #include <Windows.h>
 
 using namespace std;
@@ -47,6 +50,17 @@ void fsutil::normalize_path( wstring& path ) { //this assumes that the passed pa
     }
 }
 
+wstring fsutil::absolute_path( const wstring& path ) {
+    DWORD length = GetFullPathName( path.c_str(), 0, nullptr, nullptr );
+    if ( length == 0 ) {
+        return path;
+    }
+    wstring result( length, L'\0' );
+    length = GetFullPathName( path.c_str(), length, &result[0], nullptr );
+    result.resize( length );
+    return result;
+}
+
 wstring fsutil::dirname( const wstring& path ) {
     //the directory containing the path (hence, up directory if the path is a folder)
     size_t pos = path.find_last_of( L"\\/" );
@@ -71,37 +85,155 @@ bool fsutil::is_relative_path( const wstring& path ) {
     return path.empty() || ( path.find_first_of( L"/\\" ) != 0 && !( path.length() >= 2 && path[1] == L':' ) );
 }
 
-// Modified version of code found here: https://stackoverflow.com/a/3300547
-bool w_match( const wchar_t* needle, const wchar_t* haystack, size_t max ) {
-    for ( ; *needle != L'\0'; ++needle ) {
-        switch ( *needle ) {
-            case L'?':
-                if ( *haystack == L'\0' ) {
-                    return false;
-                }
-                ++haystack;
-                break;
-            case L'*': {
-                if ( needle[1] == L'\0' ) {
-                    return true;
-                }
-                for ( size_t i = 0; i < max; i++ ) {
-                    if ( w_match( needle + 1, haystack + i, max - i ) ) {
-                        return true;
-                    }
-                }
-                return false;
-            }
-            default:
-                if ( *haystack != *needle ) {
-                    return false;
-                }
-                ++haystack;
-        }
-    }
-    return *haystack == L'\0';
+wstring fsutil::fold_case( const wstring& str ) {
+    wstring result( str );
+    std::transform( result.begin(), result.end(), result.begin(), []( wchar_t c ) {
+        return static_cast< wchar_t >( towlower( c ) );
+    } );
+    return result;
+}
+
+// Checks if the segment (possibly containing '?' wildcards) matches str at the given position
+bool segment_match( const wstring& segment, const wstring& str, size_t pos ) {
+    for ( size_t i = 0; i < segment.size(); ++i ) {
+        if ( segment[ i ] != L'?' && segment[ i ] != str[ pos + i ] ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+WildcardMatcher::WildcardMatcher( const wstring& pattern, bool case_sensitive )
+    : mCaseSensitive( case_sensitive ), mMatchesAll( false ) {
+    addPattern( pattern );
+}
+
+WildcardMatcher::WildcardMatcher( const vector< wstring >& patterns, bool case_sensitive )
+    : mCaseSensitive( case_sensitive ), mMatchesAll( false ) {
+    for ( const wstring& pattern : patterns ) {
+        addPattern( pattern );
+    }
+}
+
+void WildcardMatcher::addPattern( const wstring& pattern ) {
+    const wstring folded_pattern = mCaseSensitive ? pattern : fsutil::fold_case( pattern );
+
+    Pattern compiled;
+    compiled.anchoredStart = folded_pattern.empty() || folded_pattern.front() != L'*';
+    compiled.anchoredEnd = folded_pattern.empty() || folded_pattern.back() != L'*';
+    compiled.minLength = 0;
+    size_t start = 0;
+    while ( start <= folded_pattern.size() ) {
+        size_t star = folded_pattern.find( L'*', start );
+        if ( star == wstring::npos ) {
+            star = folded_pattern.size();
+        }
+        if ( star > start ) { // consecutive stars are collapsed
+            compiled.segments.push_back( folded_pattern.substr( start, star - start ) );
+            compiled.minLength += star - start;
+        }
+        start = star + 1;
+    }
+
+    if ( pattern.empty() || compiled.segments.empty() ) { // an empty pattern (as well as "*") matches everything
+        mMatchesAll = true;
+        return;
+    }
+    bool has_jokers = folded_pattern.find( L'?' ) != wstring::npos;
+    if ( !has_jokers && compiled.segments.size() == 1 ) {
+        const wstring& literal = compiled.segments.front();
+        if ( compiled.anchoredStart && compiled.anchoredEnd ) {
+            mLiterals.insert( literal );
+            return;
+        }
+        if ( compiled.anchoredStart ) {
+            mPrefixes[ literal.size() ].insert( literal );
+            return;
+        }
+        if ( compiled.anchoredEnd ) {
+            mSuffixes[ literal.size() ].insert( literal );
+            return;
+        }
+    }
+    mPatterns.push_back( compiled );
+}
+
+bool WildcardMatcher::matchesPattern( const Pattern& pattern, const wstring& str ) {
+    if ( str.size() < pattern.minLength ) {
+        return false;
+    }
+    size_t first = 0;
+    size_t last = pattern.segments.size();
+    size_t pos = 0;
+    size_t end = str.size();
+    if ( pattern.anchoredStart ) {
+        const wstring& prefix = pattern.segments.front();
+        if ( !segment_match( prefix, str, 0 ) ) {
+            return false;
+        }
+        pos = prefix.size();
+        ++first;
+    }
+    if ( pattern.anchoredEnd ) {
+        if ( last == first ) { // the only segment was anchored at the start: the lengths must be equal
+            return str.size() == pattern.minLength;
+        }
+        const wstring& suffix = pattern.segments.back();
+        if ( !segment_match( suffix, str, str.size() - suffix.size() ) ) {
+            return false;
+        }
+        end = str.size() - suffix.size();
+        --last;
+    }
+    /* The remaining segments are matched at their leftmost position: since '*' can match anything, this never prevents
+     * the following segments from matching, hence no backtracking is needed. */
+    for ( size_t i = first; i < last; ++i ) {
+        const wstring& segment = pattern.segments[ i ];
+        while ( pos + segment.size() <= end && !segment_match( segment, str, pos ) ) {
+            ++pos;
+        }
+        if ( pos + segment.size() > end ) {
+            return false;
+        }
+        pos += segment.size();
+    }
+    return pos <= end;
+}
+
+bool WildcardMatcher::matches( const wstring& str ) const {
+    if ( mMatchesAll ) {
+        return true;
+    }
+    const wstring folded_str = mCaseSensitive ? wstring() : fsutil::fold_case( str );
+    const wstring& target = mCaseSensitive ? str : folded_str;
+
+    if ( !mLiterals.empty() && mLiterals.count( target ) > 0 ) {
+        return true;
+    }
+    for ( const auto& prefixes : mPrefixes ) {
+        if ( prefixes.first > target.size() ) {
+            break;
+        }
+        if ( prefixes.second.count( target.substr( 0, prefixes.first ) ) > 0 ) {
+            return true;
+        }
+    }
+    for ( const auto& suffixes : mSuffixes ) {
+        if ( suffixes.first > target.size() ) {
+            break;
+        }
+        if ( suffixes.second.count( target.substr( target.size() - suffixes.first ) ) > 0 ) {
+            return true;
+        }
+    }
+    for ( const Pattern& pattern : mPatterns ) {
+        if ( matchesPattern( pattern, target ) ) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool fsutil::wildcard_match( const wstring& pattern, const wstring& str ) {
-    return w_match( pattern.empty() ? L"*" : pattern.c_str(), str.c_str(), str.size() );
+    return WildcardMatcher( pattern ).matches( str );
 }
@@ -21,12 +21,16 @@
 
 #include "../include/memextractcallback.hpp"
 
+#include <algorithm>
+#include <exception>
+
 #include "Windows/FileDir.h"
 #include "Windows/FileFind.h"
 #include "7zip/Common/StreamObjects.h"
 
 #include "../include/bitpropvariant.hpp"
 #include "../include/bitexception.hpp"
+#include "../include/coutchunkedstream.hpp"
 #include "../include/fsutil.hpp"
 #include "../include/util.hpp"
 
@@ -59,10 +63,36 @@ static const wstring kEmptyFileAlias    = L"[Content]";
 MemExtractCallback::MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler, vector< byte_t >& buffer ) :
     mOpener( opener ),
     mArchiveHandler( archiveHandler ),
-    mBuffer( buffer ),
+    mBuffer( &buffer ),
+    mItemsBuffer( nullptr ),
+    mChunkedBuffer( &mItemChunks ),
+    mCurrentSpan( 0 ),
+    mExtractMode( true ),
+    mProcessedFileInfo(),
+    mNumErrors( 0 ) {}
+
+MemExtractCallback::MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler,
+                                        BitItemsBuffer& items ) :
+    mOpener( opener ),
+    mArchiveHandler( archiveHandler ),
+    mBuffer( &items.mData ),
+    mItemsBuffer( &items ),
+    mChunkedBuffer( nullptr ),
+    mCurrentSpan( 0 ),
+    mExtractMode( true ),
+    mProcessedFileInfo(),
+    mNumErrors( 0 ) {}
+
+MemExtractCallback::MemExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler,
+                                        BitChunkedBuffer& buffer ) :
+    mOpener( opener ),
+    mArchiveHandler( archiveHandler ),
+    mBuffer( nullptr ),
+    mItemsBuffer( nullptr ),
+    mChunkedBuffer( &buffer ),
+    mCurrentSpan( 0 ),
     mExtractMode( true ),
     mProcessedFileInfo(),
-    mOutMemStreamSpec( nullptr ),
     mNumErrors( 0 ) {}
 
 MemExtractCallback::~MemExtractCallback() {}
@@ -140,8 +170,28 @@ STDMETHODIMP MemExtractCallback::GetStream( UInt32 index, ISequentialOutStream**
     }
 
     if ( !mProcessedFileInfo.isDir ) {
-        mOutMemStreamSpec = new COutMemStream( mBuffer );
-        CMyComPtr< ISequentialOutStream > outStreamLoc( mOutMemStreamSpec );
+        if ( mItemsBuffer != nullptr ) {
+            // The content of the item will be appended to the arena: keeping the spans sorted by item index
+            vector< BitItemsBuffer::ItemSpan >& spans = mItemsBuffer->mSpans;
+            auto it = std::lower_bound( spans.begin(), spans.end(), index,
+                                        []( const BitItemsBuffer::ItemSpan& span, UInt32 idx ) {
+                return span.index < idx;
+            } );
+            BitItemsBuffer::ItemSpan span = { index, mBuffer->size(), 0 };
+            mCurrentSpan = static_cast< size_t >( spans.insert( it, span ) - spans.begin() );
+        }
+        CMyComPtr< ISequentialOutStream > outStreamLoc;
+        BitPropVariant size_prop;
+        if ( mChunkedBuffer == &mItemChunks &&
+             mArchiveHandler->GetProperty( index, kpidSize, &size_prop ) == S_OK && size_prop.isUInt64() &&
+             reserveBuffer( size_prop.getUInt64() ) ) {
+            // The size of the item is known: the output vector has been reserved exactly and it is written directly
+            outStreamLoc = new COutMemStream( *mBuffer );
+        } else if ( mChunkedBuffer != nullptr ) {
+            outStreamLoc = new COutChunkedStream( *mChunkedBuffer );
+        } else {
+            outStreamLoc = new COutMemStream( *mBuffer );
+        }
         mOutMemStream = outStreamLoc;
         *outStream = outStreamLoc.Detach();
     }
@@ -149,6 +199,21 @@ STDMETHODIMP MemExtractCallback::GetStream( UInt32 index, ISequentialOutStream**
     return S_OK;
 }
 
+bool MemExtractCallback::reserveBuffer( uint64_t item_size ) {
+    /* The item size comes from the archive headers, which may be corrupted (or malicious): if the reservation fails,
+     * the exception must not propagate to the 7-zip handler calling this callback, and the item is extracted through
+     * the chunked buffer instead (which allocates memory only as the data is actually written). */
+    if ( item_size > mBuffer->max_size() - mBuffer->size() ) {
+        return false;
+    }
+    try {
+        mBuffer->reserve( mBuffer->size() + static_cast< size_t >( item_size ) );
+    } catch ( const std::exception& ) { // e.g. std::bad_alloc or std::length_error
+        return false;
+    }
+    return true;
+}
+
 STDMETHODIMP MemExtractCallback::PrepareOperation( Int32 askExtractMode ) {
     mExtractMode = false;
 
@@ -204,6 +269,13 @@ STDMETHODIMP MemExtractCallback::SetOperationResult( Int32 operationResult ) {
 //    if ( mOutBuffStream != NULL ) {
 //        RINOK( mOutBuffStreamSpec->Close() );
 //    }
+    if ( mItemsBuffer != nullptr && mOutMemStream ) {
+        BitItemsBuffer::ItemSpan& span = mItemsBuffer->mSpans[ mCurrentSpan ];
+        span.size = mBuffer->size() - span.offset;
+    }
+    if ( mChunkedBuffer == &mItemChunks && !mItemChunks.empty() ) {
+        mItemChunks.coalesce( *mBuffer );
+    }
     mOutMemStream.Release();
 
     if ( mNumErrors > 0 ) {
@@ -92,7 +92,7 @@ HRESULT MemUpdateCallback::GetProperty( UInt32 /*index*/, PROPID propID, PROPVAR
 
     if ( propID == kpidIsAnti ) {
         prop = false;
-        *value = prop;
+        prop.detach( value );
         return S_OK;
     }
 
@@ -126,7 +126,7 @@ HRESULT MemUpdateCallback::GetProperty( UInt32 /*index*/, PROPID propID, PROPVAR
             break;
     }
 
-    *value = prop;
+    prop.detach( value ); // the value (e.g. the path string) is moved, not copied, into the output variant
     return S_OK;
 }
 
@@ -0,0 +1,191 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+#include "../include/sinkextractcallback.hpp"
+
+#include "../include/bitpropvariant.hpp"
+#include "../include/util.hpp"
+
+using namespace std;
+using namespace bit7z;
+using namespace bit7z::util;
+
+/* This class is similar to MemExtractCallback, but the content of each item is written to the sink returned by a
+ * user-provided factory, instead of a memory buffer. As the other callbacks, it doesn't throw exceptions: errors
+ * (including the ones thrown by the user functions) are memorized into mErrorMessage. */
+
+static const wstring kUnsupportedMethod = L"Unsupported Method";
+static const wstring kCRCFailed         = L"CRC Failed";
+static const wstring kDataError         = L"Data Error";
+static const wstring kUnknownError      = L"Unknown Error";
+static const wstring kSinkAborted       = L"Extraction aborted by the item sink";
+static const wstring kSinkFactoryError  = L"Cannot create the item sink";
+static const wstring kEmptyFileAlias    = L"[Content]";
+
+SinkExtractCallback::SinkExtractCallback( const BitArchiveOpener& opener, IInArchive* archiveHandler,
+                                          const SinkFactory& sinkFactory ) :
+    mOpener( opener ),
+    mArchiveHandler( archiveHandler ),
+    mSinkFactory( sinkFactory ),
+    mSink(),
+    mSinkOpened( false ),
+    mOutSinkStreamSpec( nullptr ),
+    mNumErrors( 0 ) {}
+
+SinkExtractCallback::~SinkExtractCallback() {
+    // If the extraction has been interrupted, the sink of the current item has not been closed yet
+    closeSink( false );
+}
+
+void SinkExtractCallback::closeSink( bool success ) {
+    if ( !mSinkOpened ) {
+        return;
+    }
+    mSinkOpened = false;
+    if ( mSink.close ) {
+        try {
+            mSink.close( success );
+        } catch ( ... ) {
+            // the exception cannot be propagated through the 7z DLLs
+        }
+    }
+    mSink = BitItemSink();
+}
+
+STDMETHODIMP SinkExtractCallback::SetTotal( UInt64 size ) {
+    if ( mOpener.totalCallback() ) {
+        mOpener.totalCallback()( size );
+    }
+    return S_OK;
+}
+
+STDMETHODIMP SinkExtractCallback::SetCompleted( const UInt64* completeValue ) {
+    if ( mOpener.progressCallback() ) {
+        mOpener.progressCallback()( *completeValue );
+    }
+    return S_OK;
+}
+
+STDMETHODIMP SinkExtractCallback::GetStream( UInt32 index, ISequentialOutStream** outStream, Int32 askExtractMode ) {
+    *outStream = nullptr;
+    mOutSinkStream.Release();
+    mOutSinkStreamSpec = nullptr;
+
+    if ( askExtractMode != NArchive::NExtract::NAskMode::kExtract ) {
+        return S_OK;
+    }
+
+    bool is_dir = false;
+    RINOK( IsArchiveItemFolder( mArchiveHandler, index, is_dir ) );
+    if ( is_dir ) {
+        return S_OK;
+    }
+
+    // Get Name
+    BitPropVariant prop;
+    RINOK( mArchiveHandler->GetProperty( index, kpidPath, &prop ) );
+    wstring fullPath;
+    if ( prop.isEmpty() ) {
+        fullPath = kEmptyFileAlias;
+    } else {
+        if ( prop.type() != BitPropVariantType::String ) {
+            return E_FAIL;
+        }
+        fullPath = prop.getString();
+    }
+
+    // Get Size
+    BitPropVariant size_prop;
+    RINOK( mArchiveHandler->GetProperty( index, kpidSize, &size_prop ) );
+    uint64_t size = size_prop.isUInt64() ? size_prop.getUInt64() : 0;
+
+    try {
+        mSink = mSinkFactory( index, fullPath, size );
+    } catch ( ... ) {
+        mErrorMessage = kSinkFactoryError + L" for '" + fullPath + L"'";
+        return E_ABORT;
+    }
+    mSinkOpened = true;
+
+    if ( mSink.write ) { // otherwise, the content of the item is discarded
+        mOutSinkStreamSpec = new COutSinkStream( mSink );
+        CMyComPtr< ISequentialOutStream > outStreamLoc( mOutSinkStreamSpec );
+        mOutSinkStream = outStreamLoc;
+        *outStream = outStreamLoc.Detach();
+    }
+
+    return S_OK;
+}
+
+STDMETHODIMP SinkExtractCallback::PrepareOperation( Int32 /*askExtractMode*/ ) {
+    return S_OK;
+}
+
+STDMETHODIMP SinkExtractCallback::SetOperationResult( Int32 operationResult ) {
+    switch ( operationResult ) {
+        case NArchive::NExtract::NOperationResult::kOK:
+            break;
+
+        default: {
+            mNumErrors++;
+
+            switch ( operationResult ) {
+                case NArchive::NExtract::NOperationResult::kUnsupportedMethod:
+                    mErrorMessage = kUnsupportedMethod;
+                    break;
+
+                case NArchive::NExtract::NOperationResult::kCRCError:
+                    mErrorMessage = kCRCFailed;
+                    break;
+
+                case NArchive::NExtract::NOperationResult::kDataError:
+                    mErrorMessage = kDataError;
+                    break;
+
+                default:
+                    mErrorMessage = kUnknownError;
+            }
+        }
+    }
+
+    if ( mOutSinkStreamSpec != nullptr && mOutSinkStreamSpec->isAborted() ) {
+        mErrorMessage = kSinkAborted;
+        mNumErrors++;
+    }
+    closeSink( mNumErrors == 0 );
+    mOutSinkStream.Release();
+    mOutSinkStreamSpec = nullptr;
+
+    if ( mNumErrors > 0 ) {
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+STDMETHODIMP SinkExtractCallback::CryptoGetTextPassword( BSTR* password ) {
+    if ( !mOpener.isPasswordDefined() ) {
+        mErrorMessage = L"Password is not defined";
+        return E_FAIL;
+    }
+
+    return StringToBstr( mOpener.password().c_str(), password );
+}
@@ -32,6 +32,8 @@
 #include "Common/IntToString.h"
 
 #include "../include/bitpropvariant.hpp"
+#include "../include/cbufferedinstream.hpp"
+#include "../include/cmappedinstream.hpp"
 #include "../include/fsutil.hpp"
 
 using namespace std;
@@ -46,6 +48,7 @@ using namespace bit7z;
  *  + FSItem class is used instead of CDirItem struct */
 
 const std::wstring kEmptyFileAlias = L"[Content]";
+const uint64_t kSourceViewSize = 64u * 1024 * 1024;
 
 UpdateCallback::UpdateCallback( const BitArchiveCreator& creator, const vector< FSItem >& dirItems ) :
     mVolSize( 0 ),
@@ -54,6 +57,10 @@ UpdateCallback::UpdateCallback( const BitArchiveCreator& creator, const vector<
     mAskPassword( false ) {
     mNeedBeClosed = false;
     mFailedFiles.clear();
+    if ( mCreator.readAheadFilesCount() > 0 ) {
+        mPrefetcher.reset( new FilePrefetcher( mDirItems, mCreator.readAheadFilesCount(),
+                                               mCreator.readAheadMemoryLimit() ) );
+    }
 }
 
 UpdateCallback::~UpdateCallback() {
@@ -118,11 +125,11 @@ HRESULT UpdateCallback::GetProperty( UInt32 index, PROPID propID, PROPVARIANT* v
 
     if ( propID == kpidIsAnti ) {
         prop = false;
-        *value = prop;
+        prop.detach( value );
         return S_OK;
     }
 
-    const FSItem dirItem = mDirItems[index];
+    const FSItem& dirItem = mDirItems[index];
 
     switch ( propID ) {
         case kpidPath:
@@ -150,7 +157,7 @@ HRESULT UpdateCallback::GetProperty( UInt32 index, PROPID propID, PROPVARIANT* v
             break;
     }
 
-    *value = prop;
+    prop.detach( value ); // the value (e.g. the path string) is moved, not copied, into the output variant
     return S_OK;
 }
 
@@ -164,7 +171,7 @@ HRESULT UpdateCallback::Finilize() {
 
 HRESULT UpdateCallback::GetStream( UInt32 index, ISequentialInStream** inStream ) {
     RINOK( Finilize() );
-    const FSItem dirItem = mDirItems[index];
+    const FSItem& dirItem = mDirItems[index];
 
     if ( mCreator.fileCallback() ) {
         mCreator.fileCallback()( dirItem.name() );
@@ -174,9 +181,35 @@ HRESULT UpdateCallback::GetStream( UInt32 index, ISequentialInStream** inStream
         return S_OK;
     }
 
+    if ( mPrefetcher ) {
+        CMyComPtr< ISequentialInStream > prefetchedStream = mPrefetcher->takeStream( index );
+        if ( prefetchedStream ) {
+            *inStream = prefetchedStream.Detach();
+            return S_OK;
+        }
+    }
+
+    wstring path = dirItem.path();
+    if ( mCreator.sourceInputMode() == BitInputMode::MemoryMapped ) {
+        /* Source files are read once from start to end: they are mapped through views of limited size, trimming the
+         * pages already compressed from the working set; the files that cannot be mapped (e.g. pipes) are read in
+         * large blocks. */
+        auto* mappedStreamSpec = new CMappedInStream;
+        CMyComPtr< ISequentialInStream > mappedStream( mappedStreamSpec );
+        if ( mappedStreamSpec->Open( path, true, kSourceViewSize, true ) ) {
+            *inStream = mappedStream.Detach();
+            return S_OK;
+        }
+        auto* bufferedStreamSpec = new CBufferedInStream;
+        CMyComPtr< ISequentialInStream > bufferedStream( bufferedStreamSpec );
+        if ( bufferedStreamSpec->Open( path ) ) {
+            *inStream = bufferedStream.Detach();
+            return S_OK;
+        }
+    }
+
     auto* inStreamSpec = new CInFileStream;
     CMyComPtr< ISequentialInStream > inStreamLoc( inStreamSpec );
-    wstring path = dirItem.path();
 
     if ( !inStreamSpec->Open( path.c_str() ) ) {
         DWORD sysError = ::GetLastError();
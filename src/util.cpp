@@ -21,37 +21,54 @@
 
 #include "../include/util.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
 #include <vector>
 
+#include "7zip/Common/StreamObjects.h"
+#include "Windows/FileDir.h"
+
 #include "../include/bitpropvariant.hpp"
 #include "../include/bitexception.hpp"
 #include "../include/opencallback.hpp"
+#include "../include/extractcallback.hpp"
+#include "../include/memextractcallback.hpp"
+#include "../include/memupdatecallback.hpp"
+#include "../include/coutmemstream.hpp"
+#include "../include/cmappedinstream.hpp"
+#include "../include/sinkextractcallback.hpp"
+#include "../include/fsutil.hpp"
+#include "../include/crangeinstream.hpp"
 
 using std::vector;
+using std::function;
 using namespace NWindows;
+using namespace NArchive;
 
 namespace bit7z {
     namespace util {
-        CMyComPtr< IOutArchive > initOutArchive( const Bit7zLibrary& lib, const BitInOutFormat& format,
-                                                 const BitCompressionLevel compression_level,
-                                                 const bool crypt_headers, const bool solid_mode ) {
+        CMyComPtr< IOutArchive > initOutArchive( const Bit7zLibrary& lib, const BitArchiveCreator& creator,
+                                                 uint32_t threads_count ) {
+            const BitInOutFormat& format = creator.compressionFormat();
             CMyComPtr< IOutArchive > out_archive;
             const GUID format_GUID = format.guid();
             lib.createArchiveObject( &format_GUID, &::IID_IOutArchive, reinterpret_cast< void** >( &out_archive ) );
 
             vector< const wchar_t* > names;
             vector< BitPropVariant > values;
-            if ( crypt_headers && format.hasFeature( HEADER_ENCRYPTION ) ) {
-                names.push_back( L"he" );
-                values.emplace_back( true );
-            }
-            if ( format.hasFeature( COMPRESSION_LEVEL ) ) {
-                names.push_back( L"x" );
-                values.emplace_back( static_cast< uint32_t >( compression_level ) );
-            }
-            if ( format.hasFeature( SOLID_ARCHIVE ) ) {
-                names.push_back( L"s" );
-                values.emplace_back( solid_mode );
+            creator.archiveProperties( names, values );
+            if ( threads_count > 0 ) {
+                for ( size_t i = 0; i < names.size(); ++i ) {
+                    if ( wcscmp( names[ i ], L"mt" ) == 0 ) {
+                        values[ i ] = threads_count;
+                    }
+                }
             }
 
             if ( !names.empty() ) {
@@ -68,16 +85,59 @@ namespace bit7z {
             return out_archive;
         }
 
+        /* Applies the decoder options of the opener to the (not yet opened) input archive.
+         * Not all the handlers support ISetProperties or all the properties (e.g. only the XZ handler knows "memuse"),
+         * so the failures are ignored: the options are just hints for the decoder. */
+        void setDecoderProperties( IInArchive* in_archive, const BitArchiveOpener& opener ) {
+            vector< const wchar_t* > names;
+            vector< BitPropVariant > values;
+            if ( opener.threadsCount() > 0 ) {
+                names.push_back( L"mt" );
+                values.emplace_back( opener.threadsCount() );
+            }
+            if ( opener.memoryUsageLimit() > 0 ) {
+                names.push_back( L"memuse" );
+                values.emplace_back( std::to_wstring( opener.memoryUsageLimit() ) + L"b" );
+            }
+            if ( names.empty() ) {
+                return;
+            }
+
+            CMyComPtr< ISetProperties > set_properties;
+            if ( in_archive->QueryInterface( ::IID_ISetProperties,
+                                             reinterpret_cast< void** >( &set_properties ) ) != S_OK ) {
+                return;
+            }
+            /* The handlers reset all their properties at each SetProperties call, hence they must be set all together;
+             * if the handler rejects some of them (e.g. "memuse"), only the threads count is set. */
+            HRESULT res = set_properties->SetProperties( names.data(), values.data(),
+                                                         static_cast< uint32_t >( names.size() ) );
+            if ( res != S_OK && opener.threadsCount() > 0 && names.size() > 1 ) {
+                set_properties->SetProperties( names.data(), values.data(), 1 ); // "mt" is always the first one
+            }
+        }
+
         // NOTE: this function is not a method of BitExtractor because it would dirty the header with extra dependencies
         CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
-                                             const wstring& in_file, const BitArchiveOpener& opener ) {
+                                             const wstring& in_file, const BitArchiveOpener& opener,
+                                             bool sequential_access ) {
             CMyComPtr< IInArchive > in_archive;
             const GUID format_GUID = format.guid();
             lib.createArchiveObject( &format_GUID, &::IID_IInArchive, reinterpret_cast< void** >( &in_archive ) );
+            setDecoderProperties( in_archive, opener );
 
-            auto* file_stream_spec = new CInFileStream;
-            CMyComPtr< IInStream > file_stream = file_stream_spec;
-            if ( !file_stream_spec->Open( in_file.c_str() ) ) {
+            CMyComPtr< IInStream > file_stream;
+            bool opened;
+            if ( opener.inputMode() == BitInputMode::MemoryMapped ) {
+                auto* mapped_stream_spec = new CMappedInStream;
+                file_stream = mapped_stream_spec;
+                opened = mapped_stream_spec->Open( in_file, sequential_access, opener.mappingViewLimit() );
+            } else {
+                auto* file_stream_spec = new CInFileStream;
+                file_stream = file_stream_spec;
+                opened = file_stream_spec->Open( in_file.c_str() );
+            }
+            if ( !opened ) {
                 throw BitException( L"Cannot open archive file '" + in_file + L"'" );
             }
 
@@ -91,6 +151,270 @@ namespace bit7z {
             return in_archive;
         }
 
+        CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
+                                             const vector< byte_t >& in_buffer, const BitArchiveOpener& opener ) {
+            if ( in_buffer.empty() ) {
+                throw BitException( "Cannot open an empty buffer archive" );
+            }
+
+            CMyComPtr< IInArchive > in_archive;
+            const GUID format_GUID = format.guid();
+            lib.createArchiveObject( &format_GUID, &::IID_IInArchive, reinterpret_cast< void** >( &in_archive ) );
+            setDecoderProperties( in_archive, opener );
+
+            auto* buf_stream_spec = new CBufInStream;
+            CMyComPtr< IInStream > buf_stream( buf_stream_spec );
+            buf_stream_spec->Init( &in_buffer[0], in_buffer.size() );
+
+            auto* open_callback_spec = new OpenCallback( opener );
+
+            CMyComPtr< IArchiveOpenCallback > open_callback( open_callback_spec );
+            if ( in_archive->Open( buf_stream, nullptr, open_callback ) != S_OK ) {
+                throw BitException( "Cannot open archive buffer" );
+            }
+            return in_archive;
+        }
+
+        CMyComPtr< IInArchive > openArchive( const Bit7zLibrary& lib, const BitInFormat& format,
+                                             IInStream* in_stream, const BitArchiveOpener& opener ) {
+            CMyComPtr< IInArchive > in_archive;
+            const GUID format_GUID = format.guid();
+            lib.createArchiveObject( &format_GUID, &::IID_IInArchive, reinterpret_cast< void** >( &in_archive ) );
+            setDecoderProperties( in_archive, opener );
+
+            auto* open_callback_spec = new OpenCallback( opener );
+
+            CMyComPtr< IArchiveOpenCallback > open_callback( open_callback_spec );
+            if ( in_archive->Open( in_stream, nullptr, open_callback ) != S_OK ) {
+                throw BitException( "Cannot open archive stream" );
+            }
+            return in_archive;
+        }
+
+        uint32_t itemsCount( IInArchive* in_archive ) {
+            uint32_t items_count;
+            if ( in_archive->GetNumberOfItems( &items_count ) != S_OK ) {
+                throw BitException( "Could not retrieve the number of items in the archive" );
+            }
+            return items_count;
+        }
+
+        void checkIndices( IInArchive* in_archive, const vector< uint32_t >& indices ) {
+            uint32_t number_items = itemsCount( in_archive );
+            if ( std::any_of( indices.begin(), indices.end(), [&]( uint32_t index ) { return index >= number_items; } ) ) {
+                /* if any of the indices is greater than the number of items in the archive we throw an exception,
+                   since it is an invalid index! */
+                throw BitException( "Some index is not valid" );
+            }
+        }
+
+        void orderIndices( IInArchive* in_archive, vector< uint32_t >& indices ) {
+            /* IInArchive::Extract requires the indices to be sorted (handlers of solid formats like RAR and TAR decode
+             * the items in that order); moreover, each item must be extracted only once. */
+            std::sort( indices.begin(), indices.end() );
+            indices.erase( std::unique( indices.begin(), indices.end() ), indices.end() );
+            checkIndices( in_archive, indices );
+        }
+
+        vector< uint32_t > matchingIndices( IInArchive* in_archive, const wstring& item_filter ) {
+            if ( item_filter.empty() ) {
+                return vector< uint32_t >();
+            }
+            const filesystem::WildcardMatcher matcher( item_filter );
+            return matchingIndices( in_archive, [ &matcher ]( uint32_t, const wstring& item_path ) {
+                return matcher.matches( item_path );
+            } );
+        }
+
+        vector< uint32_t > matchingIndices( IInArchive* in_archive, const vector< wstring >& item_filters,
+                                            bool case_sensitive ) {
+            if ( item_filters.empty() ) {
+                return vector< uint32_t >();
+            }
+            const filesystem::WildcardMatcher matcher( item_filters, case_sensitive );
+            return matchingIndices( in_archive, [ &matcher ]( uint32_t, const wstring& item_path ) {
+                return matcher.matches( item_path );
+            } );
+        }
+
+        vector< uint32_t > matchingIndices( IInArchive* in_archive, const ItemPredicate& predicate ) {
+            vector< uint32_t > matched_indices;
+            //Searching for files inside the archive that satisfy the given predicate
+            uint32_t items_count;
+            HRESULT result = in_archive->GetNumberOfItems( &items_count );
+            if ( result == S_OK ) {
+                for ( uint32_t index = 0; index < items_count; ++index ) {
+                    BitPropVariant propvar;
+                    result = in_archive->GetProperty( index, kpidPath, &propvar );
+                    if ( result == S_OK && !propvar.isEmpty() && propvar.type() == BitPropVariantType::String &&
+                            predicate( index, propvar.getString() ) ) {
+                        matched_indices.push_back( index );
+                    }
+                }
+            }
+            return matched_indices;
+        }
+
+        void checkFreeSpace( IInArchive* in_archive, const vector< uint32_t >& indices, const wstring& out_dir ) {
+            uint64_t total_size = 0;
+            auto add_item_size = [&]( uint32_t index ) {
+                BitPropVariant size_prop;
+                if ( in_archive->GetProperty( index, kpidSize, &size_prop ) == S_OK && size_prop.isUInt64() ) {
+                    total_size += size_prop.getUInt64();
+                }
+            };
+            if ( indices.empty() ) { // all the items
+                uint32_t items_count = itemsCount( in_archive );
+                for ( uint32_t index = 0; index < items_count; ++index ) {
+                    add_item_size( index );
+                }
+            } else {
+                std::for_each( indices.begin(), indices.end(), add_item_size );
+            }
+
+            if ( !out_dir.empty() ) {
+                NFile::NDir::CreateComplexDir( out_dir.c_str() );
+            }
+            ULARGE_INTEGER free_space;
+            // If the free space cannot be retrieved (e.g. network shares not supporting it), the check is skipped
+            if ( GetDiskFreeSpaceEx( out_dir.empty() ? nullptr : out_dir.c_str(), &free_space, nullptr, nullptr ) &&
+                 free_space.QuadPart < total_size ) {
+                throw BitException( L"Not enough free space to extract " + std::to_wstring( total_size ) +
+                                    L" bytes (available: " + std::to_wstring( free_space.QuadPart ) + L" bytes)" );
+            }
+        }
+
+        void extractToFileSystem( IInArchive* in_archive, const BitArchiveOpener& opener, const wstring& in_file,
+                                  const wstring& out_dir, vector< uint32_t > indices ) {
+            orderIndices( in_archive, indices );
+            if ( opener.freeSpaceCheck() ) {
+                checkFreeSpace( in_archive, indices, out_dir );
+            }
+            //pointer to an array of the indices of the files to be extracted
+            const uint32_t* item_indices = indices.empty() ? nullptr : indices.data();
+            uint32_t num_items = indices.empty() ? static_cast< uint32_t >( -1 ) :
+                                 static_cast< uint32_t >( indices.size() );
+
+            auto* extract_callback_spec = new ExtractCallback( opener, in_archive, in_file, out_dir );
+
+            CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
+            HRESULT res = in_archive->Extract( item_indices, num_items, NExtract::NAskMode::kExtract, extract_callback );
+            if ( res != S_OK ) {
+                throw BitException( extract_callback_spec->getErrorMessage() +
+                                    L" (error code: " + std::to_wstring( res ) + L")" );
+            }
+        }
+
+        template< typename T >
+        void extractItemToBuffer( IInArchive* in_archive, const BitArchiveOpener& opener, T& out_buffer,
+                                  uint32_t index ) {
+            if ( index >= itemsCount( in_archive ) ) {
+                throw BitException( "Index " + std::to_string( index ) + " is out of range"  );
+            }
+
+            auto* extract_callback_spec = new MemExtractCallback( opener, in_archive, out_buffer );
+
+            const uint32_t indices[] = { index };
+
+            CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
+            if ( in_archive->Extract( indices, 1, NExtract::NAskMode::kExtract, extract_callback ) != S_OK ) {
+                throw BitException( extract_callback_spec->getErrorMessage() );
+            }
+        }
+
+        void extractToBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                              vector< byte_t >& out_buffer, uint32_t index ) {
+            extractItemToBuffer( in_archive, opener, out_buffer, index );
+        }
+
+        void extractToBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                              BitChunkedBuffer& out_buffer, uint32_t index ) {
+            extractItemToBuffer( in_archive, opener, out_buffer, index );
+        }
+
+        void extractToItemsBuffer( IInArchive* in_archive, const BitArchiveOpener& opener,
+                                   vector< uint32_t > indices, BitItemsBuffer& out_items ) {
+            out_items.clear();
+            if ( indices.empty() ) { // all the items
+                indices.resize( itemsCount( in_archive ) );
+                std::iota( indices.begin(), indices.end(), 0 );
+            }
+            orderIndices( in_archive, indices );
+            if ( indices.empty() ) {
+                return;
+            }
+
+            /* Reserving the arena in advance (if the sizes of the items are known), so that it is never reallocated
+             * (and copied) during the extraction. The sizes come from the archive headers, which may be corrupted
+             * (or malicious): the sum saturates, and the reservation is skipped (the arena then simply grows as the
+             * data is written) if it is not plausible with respect to the physical size of the archive, or if it
+             * fails. */
+            const uint64_t max_ratio = 1024;
+            uint64_t total_size = 0;
+            for ( uint32_t index : indices ) {
+                BitPropVariant size_prop;
+                if ( in_archive->GetProperty( index, kpidSize, &size_prop ) == S_OK && size_prop.isUInt64() ) {
+                    uint64_t item_size = size_prop.getUInt64();
+                    total_size = item_size > UINT64_MAX - total_size ? UINT64_MAX : total_size + item_size;
+                }
+            }
+            BitPropVariant phy_size_prop;
+            bool plausible_size = true;
+            if ( in_archive->GetArchiveProperty( kpidPhySize, &phy_size_prop ) == S_OK && phy_size_prop.isUInt64() ) {
+                uint64_t phy_size = phy_size_prop.getUInt64();
+                plausible_size = phy_size > UINT64_MAX / max_ratio || total_size <= phy_size * max_ratio;
+            }
+            if ( total_size > 0 && plausible_size && total_size <= out_items.data().max_size() ) {
+                try {
+                    out_items.reserve( static_cast< size_t >( total_size ) );
+                } catch ( const std::exception& ) { // e.g. std::bad_alloc or std::length_error
+                    // the arena is not reserved, and it grows during the extraction
+                }
+            }
+
+            auto* extract_callback_spec = new MemExtractCallback( opener, in_archive, out_items );
+
+            CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
+            HRESULT res = in_archive->Extract( indices.data(), static_cast< uint32_t >( indices.size() ),
+                                               NExtract::NAskMode::kExtract, extract_callback );
+            if ( res != S_OK ) {
+                out_items.clear();
+                throw BitException( extract_callback_spec->getErrorMessage() );
+            }
+        }
+
+        void extractToSinks( IInArchive* in_archive, const BitArchiveOpener& opener,
+                             const SinkFactory& sink_factory, vector< uint32_t > indices ) {
+            orderIndices( in_archive, indices );
+            const uint32_t* item_indices = indices.empty() ? nullptr : indices.data();
+            uint32_t num_items = indices.empty() ? static_cast< uint32_t >( -1 ) :
+                                 static_cast< uint32_t >( indices.size() );
+
+            auto* extract_callback_spec = new SinkExtractCallback( opener, in_archive, sink_factory );
+
+            CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
+            HRESULT res = in_archive->Extract( item_indices, num_items, NExtract::NAskMode::kExtract, extract_callback );
+            if ( res != S_OK ) {
+                wstring error_message = extract_callback_spec->getErrorMessage();
+                if ( error_message.empty() && res == E_ABORT ) {
+                    error_message = L"Extraction aborted by the item sink";
+                }
+                throw BitException( error_message + L" (error code: " + std::to_wstring( res ) + L")" );
+            }
+        }
+
+        void testArchive( IInArchive* in_archive, const BitArchiveOpener& opener, const wstring& in_file ) {
+            auto* extract_callback_spec = new ExtractCallback( opener, in_archive, in_file, L"" );
+
+            CMyComPtr< IArchiveExtractCallback > extract_callback( extract_callback_spec );
+            HRESULT res = in_archive->Extract( nullptr, static_cast< uint32_t >( -1 ),
+                                               NExtract::NAskMode::kTest, extract_callback );
+            if ( res != S_OK ) {
+                throw BitException( extract_callback_spec->getErrorMessage() +
+                                    L" (error code: " + std::to_wstring( res ) + L")" );
+            }
+        }
+
         HRESULT IsArchiveItemProp( IInArchive* archive, UInt32 index, PROPID propID, bool& result ) {
             BitPropVariant prop;
             RINOK( archive->GetProperty( index, propID, &prop ) );
@@ -109,5 +433,370 @@ namespace bit7z {
         HRESULT IsArchiveItemFolder( IInArchive* archive, UInt32 index, bool& result ) {
             return IsArchiveItemProp( archive, index, kpidIsDir, result );
         }
+
+        uint32_t hardwareThreads() {
+            uint32_t threads = std::thread::hardware_concurrency();
+            if ( threads == 0 ) { // hardware_concurrency() may return 0 if the value is not computable
+                threads = 1;
+            }
+            // The process may be restricted to a subset of the processors (e.g. by a job object or by "start /affinity")
+            DWORD_PTR process_mask = 0;
+            DWORD_PTR system_mask = 0;
+            if ( GetProcessAffinityMask( GetCurrentProcess(), &process_mask, &system_mask ) && process_mask != 0 ) {
+                uint32_t allowed_threads = 0;
+                for ( ; process_mask != 0; process_mask &= process_mask - 1 ) {
+                    ++allowed_threads;
+                }
+                threads = std::min( threads, allowed_threads );
+            }
+            return threads;
+        }
+
+        void parallelFor( uint32_t tasks_count, uint32_t threads_count, const function< void( uint32_t, uint32_t ) >& task ) {
+            if ( threads_count == 0 ) {
+                threads_count = hardwareThreads();
+            }
+            threads_count = std::min( threads_count, tasks_count );
+            if ( threads_count <= 1 ) { // no need to spawn threads
+                for ( uint32_t i = 0; i < tasks_count; ++i ) {
+                    task( i, 0 );
+                }
+                return;
+            }
+
+            std::atomic< uint32_t > next_task( 0 );
+            std::atomic< bool > failed( false );
+            std::exception_ptr first_error;
+            std::mutex error_mutex;
+
+            auto worker = [&]( uint32_t worker_index ) {
+                uint32_t task_index;
+                while ( !failed && ( task_index = next_task++ ) < tasks_count ) {
+                    try {
+                        task( task_index, worker_index );
+                    } catch ( ... ) {
+                        std::lock_guard< std::mutex > lock( error_mutex );
+                        if ( !first_error ) {
+                            first_error = std::current_exception();
+                        }
+                        failed = true;
+                    }
+                }
+            };
+
+            vector< std::thread > workers;
+            workers.reserve( threads_count - 1 );
+            for ( uint32_t i = 1; i < threads_count; ++i ) {
+                workers.emplace_back( worker, i );
+            }
+            worker( 0 ); // the calling thread works too
+            for ( auto& thread : workers ) {
+                thread.join();
+            }
+
+            if ( first_error ) {
+                std::rethrow_exception( first_error );
+            }
+        }
+
+        ChunkReader streamChunkReader( IInStream* in_stream ) {
+            struct SharedStream {
+                CMyComPtr< IInStream > stream;
+                std::mutex mutex;
+            };
+            auto shared_stream = std::make_shared< SharedStream >();
+            shared_stream->stream = in_stream;
+            return [ shared_stream ]( uint64_t offset, vector< byte_t >& chunk ) {
+                std::lock_guard< std::mutex > lock( shared_stream->mutex );
+                if ( shared_stream->stream->Seek( static_cast< Int64 >( offset ), STREAM_SEEK_SET, nullptr ) != S_OK ) {
+                    throw BitException( "Cannot read the input stream" );
+                }
+                size_t read_size = 0;
+                while ( read_size < chunk.size() ) {
+                    UInt32 processed_size = 0;
+                    auto size = static_cast< UInt32 >( std::min< size_t >( chunk.size() - read_size, 1u << 30 ) );
+                    if ( shared_stream->stream->Read( &chunk[ read_size ], size, &processed_size ) != S_OK ||
+                            processed_size == 0 ) {
+                        throw BitException( "Cannot read the input stream" );
+                    }
+                    read_size += processed_size;
+                }
+            };
+        }
+
+        ChunkReader bufferChunkReader( const vector< byte_t >& in_buffer ) {
+            return [ &in_buffer ]( uint64_t offset, vector< byte_t >& chunk ) {
+                auto chunk_begin = in_buffer.begin() + static_cast< ptrdiff_t >( offset );
+                std::copy( chunk_begin, chunk_begin + static_cast< ptrdiff_t >( chunk.size() ), chunk.begin() );
+            };
+        }
+
+        RangeStreamOpener fileRangeOpener( const wstring& in_file ) {
+            return [ in_file ]( uint64_t begin, uint64_t end ) -> CMyComPtr< IInStream > {
+                // each range has its own file stream, so that the workers do not contend for a single file position
+                auto* file_stream_spec = new CInFileStream;
+                CMyComPtr< IInStream > file_stream = file_stream_spec;
+                if ( !file_stream_spec->Open( in_file.c_str() ) ) {
+                    throw BitException( L"Cannot open archive file '" + in_file + L"'" );
+                }
+                return new CRangeInStream( file_stream, begin, end - begin );
+            };
+        }
+
+        RangeStreamOpener bufferRangeOpener( const vector< byte_t >& in_buffer ) {
+            return [ &in_buffer ]( uint64_t begin, uint64_t end ) -> CMyComPtr< IInStream > {
+                auto* buf_stream_spec = new CBufInStream;
+                CMyComPtr< IInStream > buf_stream( buf_stream_spec );
+                buf_stream_spec->Init( in_buffer.data() + begin, static_cast< size_t >( end - begin ) );
+                return buf_stream;
+            };
+        }
+
+        void writeData( ISequentialOutStream* out_stream, const byte_t* data, size_t remaining ) {
+            while ( remaining > 0 ) {
+                UInt32 processed_size = 0;
+                auto size = static_cast< UInt32 >( std::min< size_t >( remaining, 1u << 30 ) );
+                if ( out_stream->Write( data, size, &processed_size ) != S_OK || processed_size == 0 ) {
+                    throw BitException( "Cannot write the data to the output stream" );
+                }
+                data += processed_size;
+                remaining -= processed_size;
+            }
+        }
+
+        void writeBuffer( ISequentialOutStream* out_stream, const vector< byte_t >& buffer ) {
+            writeData( out_stream, buffer.data(), buffer.size() );
+        }
+
+        void compressMembers( const Bit7zLibrary& lib, const BitArchiveCreator& creator, uint64_t in_size,
+                              const ChunkReader& read_chunk, const wstring& item_name,
+                              ISequentialOutStream* out_stream ) {
+            const uint64_t chunk_size = creator.chunkSize();
+            if ( chunk_size == 0 ) {
+                throw BitException( "The chunk size must be set for compressing multiple members" );
+            }
+            // an empty input is still compressed into a (single) member, so that the output is a valid archive
+            uint64_t chunks_count = std::max< uint64_t >( ( in_size + chunk_size - 1 ) / chunk_size, 1 );
+            uint32_t threads_count = creator.effectiveThreadsCount();
+
+            /* The chunks are processed in rounds of (at most) two chunks per thread, so that the memory used is bounded
+             * while the compressed members can still be written in the same order of the chunks. */
+            const uint64_t round_size = 2ull * threads_count;
+            for ( uint64_t round_start = 0; round_start < chunks_count; round_start += round_size ) {
+                auto round_chunks = static_cast< uint32_t >( std::min( round_size, chunks_count - round_start ) );
+                vector< vector< byte_t > > members( round_chunks );
+                parallelFor( round_chunks, threads_count, [&]( uint32_t task, uint32_t ) {
+                    uint64_t offset = ( round_start + task ) * chunk_size;
+                    vector< byte_t > chunk( static_cast< size_t >( std::min( chunk_size, in_size - offset ) ) );
+                    if ( !chunk.empty() ) {
+                        read_chunk( offset, chunk );
+                    }
+
+                    CMyComPtr< IOutArchive > out_arc = initOutArchive( lib, creator );
+                    auto* out_mem_stream_spec = new COutMemStream( members[ task ] );
+                    CMyComPtr< ISequentialOutStream > out_mem_stream( out_mem_stream_spec );
+                    auto* update_callback_spec = new MemUpdateCallback( creator, chunk, item_name );
+                    CMyComPtr< IArchiveUpdateCallback > update_callback( update_callback_spec );
+                    HRESULT result = out_arc->UpdateItems( out_mem_stream, 1, update_callback );
+                    update_callback_spec->Finilize();
+                    if ( result != S_OK ) {
+                        throw BitException( update_callback_spec->getErrorMessage().empty() ?
+                                            L"Failed operation (unkwown error)!" : update_callback_spec->getErrorMessage() );
+                    }
+                } );
+
+                for ( auto& member : members ) {
+                    writeBuffer( out_stream, member );
+                    vector< byte_t >().swap( member );
+                }
+            }
+        }
+
+        bool isMemberSignature( const BitInFormat& format, const byte_t* data ) {
+            if ( format == BitFormat::GZip ) {
+                /* ID1, ID2, CM (8 = deflate), FLG (whose three most significant bits are reserved and must be zero),
+                 * XFL (0, 2 or 4 for deflate) and OS (0 to 13, or 255 for unknown); the four bytes of MTIME can have
+                 * any value. Note: the trailer (CRC32 and ISIZE) of the previous member is verified by its decoder. */
+                return data[ 0 ] == 0x1F && data[ 1 ] == 0x8B && data[ 2 ] == 0x08 && ( data[ 3 ] & 0xE0 ) == 0 &&
+                       ( data[ 8 ] == 0 || data[ 8 ] == 2 || data[ 8 ] == 4 ) && ( data[ 9 ] <= 13 || data[ 9 ] == 255 );
+            }
+            // "BZh" and the block size ('1' to '9'), followed by the magic of the first block or of the end of stream
+            static const byte_t block_magic[] = { 0x31, 0x41, 0x59, 0x26, 0x53, 0x59 };
+            static const byte_t end_magic[] = { 0x17, 0x72, 0x45, 0x38, 0x50, 0x90 };
+            return data[ 0 ] == 'B' && data[ 1 ] == 'Z' && data[ 2 ] == 'h' && data[ 3 ] >= '1' && data[ 3 ] <= '9' &&
+                   ( std::equal( block_magic, block_magic + 6, data + 4 ) ||
+                     std::equal( end_magic, end_magic + 6, data + 4 ) );
+        }
+
+        vector< uint64_t > findMembers( const BitInFormat& format, uint64_t in_size, const ChunkReader& read_chunk ) {
+            if ( format != BitFormat::GZip && format != BitFormat::BZip2 ) {
+                throw BitException( "Only GZip and BZip2 inputs can be made of multiple members" );
+            }
+            const size_t signature_size = 10;
+            const size_t block_size = 1u << 22;
+            const byte_t first_byte = format == BitFormat::GZip ? 0x1F : 'B';
+
+            vector< uint64_t > result( 1, 0 );
+            vector< byte_t > block;
+            // the blocks overlap by signature_size - 1 bytes, so that no signature is split between two blocks
+            for ( uint64_t offset = 0; offset + signature_size <= in_size; offset += block_size - signature_size + 1 ) {
+                block.resize( static_cast< size_t >( std::min< uint64_t >( block_size, in_size - offset ) ) );
+                read_chunk( offset, block );
+                const byte_t* block_end = block.data() + block.size() - signature_size + 1;
+                for ( const byte_t* it = block.data(); it < block_end; ++it ) {
+                    it = static_cast< const byte_t* >( memchr( it, first_byte, static_cast< size_t >( block_end - it ) ) );
+                    if ( it == nullptr ) {
+                        break;
+                    }
+                    uint64_t member_offset = offset + static_cast< uint64_t >( it - block.data() );
+                    if ( member_offset > result.back() && isMemberSignature( format, it ) ) {
+                        result.push_back( member_offset );
+                    }
+                }
+                if ( offset + block.size() >= in_size ) {
+                    break;
+                }
+            }
+            return result;
+        }
+
+        // Decompresses the input range [begin, end) as a single archive, returning false if it is not valid
+        bool extractMember( const Bit7zLibrary& lib, const BitInFormat& format, const BitArchiveOpener& opener,
+                            const RangeStreamOpener& open_range, uint64_t begin, uint64_t end,
+                            const function< bool( const byte_t*, size_t ) >& write ) {
+            CMyComPtr< IInStream > member_stream = open_range( begin, end );
+            try {
+                CMyComPtr< IInArchive > in_archive = openArchive( lib, format, member_stream, opener );
+                if ( itemsCount( in_archive ) != 1 ) {
+                    return false;
+                }
+                extractToSinks( in_archive, opener, [ &write ]( uint32_t, const wstring&, uint64_t ) {
+                    BitItemSink sink;
+                    sink.write = write;
+                    return sink;
+                }, vector< uint32_t >( 1, 0 ) );
+                return true;
+            } catch ( const BitException& ) {
+                return false;
+            }
+        }
+
+        /* Writes the output of a member directly to the output stream. If the member fails and is decompressed again
+         * (merged with the following ones), the data already written by the previous attempts is skipped. */
+        struct MemberWriter {
+            ISequentialOutStream* out_stream;
+            uint64_t skip;
+            uint64_t position;
+            bool failed;
+
+            explicit MemberWriter( ISequentialOutStream* stream )
+                : out_stream( stream ), skip( 0 ), position( 0 ), failed( false ) {}
+
+            bool write( const byte_t* data, size_t size ) {
+                uint64_t end = position + size;
+                if ( end > skip ) {
+                    auto skipped = static_cast< size_t >( position < skip ? skip - position : 0 );
+                    try {
+                        writeData( out_stream, data + skipped, size - skipped );
+                    } catch ( const BitException& ) {
+                        failed = true;
+                        return false;
+                    }
+                }
+                position = end;
+                return true;
+            }
+
+            void restart() {
+                skip = std::max( skip, position );
+                position = 0;
+            }
+        };
+
+        void extractMembers( const Bit7zLibrary& lib, const BitInFormat& format, const BitArchiveOpener& opener,
+                             uint64_t in_size, const ChunkReader& read_chunk, const RangeStreamOpener& open_range,
+                             uint32_t threads_count, ISequentialOutStream* out_stream ) {
+            vector< uint64_t > offsets = findMembers( format, in_size, read_chunk );
+            offsets.push_back( in_size );
+            const size_t members_count = offsets.size() - 1;
+            if ( threads_count == 0 ) {
+                threads_count = hardwareThreads();
+            }
+
+            /* The members are decompressed in rounds of (at most) two members per thread, to bound the memory used.
+             * The first member of each round is written directly to the output stream while it is decompressed, and
+             * only the outputs of the following ones are buffered until their turn comes. Note: the input is always
+             * scanned once by findMembers before decompressing it; an input with no candidate offset other than 0 is
+             * then decompressed in streaming, as in a usual extraction. */
+            const size_t round_size = 2u * threads_count;
+            size_t next_member = 0;
+            while ( next_member < members_count ) {
+                auto round_members = static_cast< uint32_t >( std::min( round_size, members_count - next_member ) );
+                MemberWriter head_writer( out_stream );
+                std::unique_ptr< BitChunkedBuffer[] > outputs( new BitChunkedBuffer[ round_members ] );
+                std::unique_ptr< bool[] > succeeded( new bool[ round_members ]() );
+                parallelFor( round_members, threads_count, [&]( uint32_t task, uint32_t ) {
+                    size_t member = next_member + task;
+                    if ( task == 0 ) {
+                        succeeded[ task ] = extractMember( lib, format, opener, open_range, offsets[ member ],
+                                                           offsets[ member + 1 ],
+                                                           [ &head_writer ]( const byte_t* data, size_t size ) {
+                                                               return head_writer.write( data, size );
+                                                           } );
+                        return;
+                    }
+                    BitChunkedBuffer& output = outputs[ task ];
+                    succeeded[ task ] = extractMember( lib, format, opener, open_range, offsets[ member ],
+                                                       offsets[ member + 1 ],
+                                                       [ &output ]( const byte_t* data, size_t size ) {
+                                                           try {
+                                                               output.append( data, size );
+                                                               return true;
+                                                           } catch ( const std::exception& ) {
+                                                               return false;
+                                                           }
+                                                       } );
+                    if ( !succeeded[ task ] ) {
+                        output.clear();
+                    }
+                } );
+                if ( head_writer.failed ) {
+                    throw BitException( "Cannot write the data to the output stream" );
+                }
+
+                size_t round_end = next_member + round_members;
+                for ( uint32_t task = 0; task < round_members; ++task ) {
+                    if ( succeeded[ task ] ) {
+                        for ( const BitBufferSegment& segment : outputs[ task ].segments() ) {
+                            writeData( out_stream, segment.data, segment.size );
+                        }
+                        outputs[ task ].clear();
+                        continue;
+                    }
+                    /* The member does not end at a real boundary (since it starts at a real one, i.e. at the end of the
+                     * previous member): the rest of the input is decompressed sequentially, in a single pass, rather
+                     * than retrying with ranges growing one candidate at a time (which would decode the same data
+                     * again for each false candidate). The data already written by the failed attempt is skipped. */
+                    MemberWriter writer( out_stream );
+                    if ( task == 0 ) {
+                        writer = head_writer;
+                    }
+                    writer.restart();
+                    bool rest_succeeded = extractMember( lib, format, opener, open_range, offsets[ next_member + task ],
+                                                         in_size, [ &writer ]( const byte_t* data, size_t size ) {
+                                                             return writer.write( data, size );
+                                                         } );
+                    if ( writer.failed ) {
+                        throw BitException( "Cannot write the data to the output stream" );
+                    }
+                    if ( !rest_succeeded ) {
+                        throw BitException( "Cannot decompress the input archive" );
+                    }
+                    round_end = members_count; // the outputs of the remaining members of the round are discarded
+                    break;
+                }
+                next_member = round_end;
+            }
+        }
     }
 }
@@ -0,0 +1,294 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/*
+ * bit7z - A C++ static library to interface with the 7-zip DLLs.
+ * Copyright (c) 2014-2018  Riccardo Ostani - All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * Bit7z is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bit7z; if not, see https://www.gnu.org/licenses/.
+ */
+
+
+#include "../include/zipmerger.hpp"
+
+#include <algorithm>
+
+#include "7zip/Common/FileStreams.h"
+
+#include "../include/bitexception.hpp"
+#include "../include/util.hpp"
+
+using namespace bit7z;
+using namespace bit7z::util;
+
+namespace {
+    const uint32_t kCentralHeaderSignature = 0x02014B50;
+    const uint32_t kEndOfCentralDirSignature = 0x06054B50;
+    const uint32_t kZip64EndOfCentralDirSignature = 0x06064B50;
+    const uint32_t kZip64LocatorSignature = 0x07064B50;
+    const uint16_t kZip64ExtraId = 0x0001;
+    const uint16_t kZip64Version = 45;
+
+    const size_t kCentralHeaderSize = 46;
+    const size_t kEndOfCentralDirSize = 22;
+    const size_t kZip64LocatorSize = 20;
+    const size_t kZip64EndOfCentralDirSize = 56;
+
+    const size_t kCopyBlockSize = 1u << 22;
+
+    uint16_t getUInt16( const byte_t* data ) {
+        return static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) );
+    }
+
+    uint32_t getUInt32( const byte_t* data ) {
+        return static_cast< uint32_t >( getUInt16( data ) ) | ( static_cast< uint32_t >( getUInt16( data + 2 ) ) << 16 );
+    }
+
+    uint64_t getUInt64( const byte_t* data ) {
+        return static_cast< uint64_t >( getUInt32( data ) ) | ( static_cast< uint64_t >( getUInt32( data + 4 ) ) << 32 );
+    }
+
+    void setUInt16( byte_t* data, uint16_t value ) {
+        data[ 0 ] = static_cast< byte_t >( value & 0xFF );
+        data[ 1 ] = static_cast< byte_t >( value >> 8 );
+    }
+
+    void setUInt32( byte_t* data, uint32_t value ) {
+        setUInt16( data, static_cast< uint16_t >( value & 0xFFFF ) );
+        setUInt16( data + 2, static_cast< uint16_t >( value >> 16 ) );
+    }
+
+    void appendUInt16( vector< byte_t >& buffer, uint16_t value ) {
+        byte_t data[ 2 ];
+        setUInt16( data, value );
+        buffer.insert( buffer.end(), data, data + 2 );
+    }
+
+    void appendUInt32( vector< byte_t >& buffer, uint32_t value ) {
+        byte_t data[ 4 ];
+        setUInt32( data, value );
+        buffer.insert( buffer.end(), data, data + 4 );
+    }
+
+    void appendUInt64( vector< byte_t >& buffer, uint64_t value ) {
+        appendUInt32( buffer, static_cast< uint32_t >( value & 0xFFFFFFFF ) );
+        appendUInt32( buffer, static_cast< uint32_t >( value >> 32 ) );
+    }
+
+    uint32_t saturate32( uint64_t value ) {
+        return value >= 0xFFFFFFFF ? 0xFFFFFFFF : static_cast< uint32_t >( value );
+    }
+
+    uint16_t saturate16( uint64_t value ) {
+        return value >= 0xFFFF ? 0xFFFF : static_cast< uint16_t >( value );
+    }
+}
+
+ZipMerger::ZipMerger( ISequentialOutStream* out_stream )
+    : mOutStream( out_stream ), mOffset( 0 ), mEntriesCount( 0 ) {}
+
+void ZipMerger::append( const wstring& in_archive ) {
+    auto* in_file_stream_spec = new CInFileStream;
+    CMyComPtr< IInStream > in_file_stream( in_file_stream_spec );
+    uint64_t archive_size = 0;
+    if ( !in_file_stream_spec->Open( in_archive.c_str() ) || in_file_stream_spec->GetSize( &archive_size ) != S_OK ) {
+        throw BitException( L"Cannot open archive file '" + in_archive + L"'" );
+    }
+    ChunkReader read_chunk = streamChunkReader( in_file_stream );
+    const std::string format_error = "Cannot merge a malformed ZIP archive";
+
+    // The archives created by 7-zip have no comment, hence the end of central directory record is at the end
+    if ( archive_size < kEndOfCentralDirSize ) {
+        throw BitException( format_error );
+    }
+    vector< byte_t > record( kEndOfCentralDirSize );
+    read_chunk( archive_size - kEndOfCentralDirSize, record );
+    if ( getUInt32( record.data() ) != kEndOfCentralDirSignature ) {
+        throw BitException( format_error );
+    }
+    uint64_t entries_count = getUInt16( record.data() + 10 );
+    uint64_t directory_size = getUInt32( record.data() + 12 );
+    uint64_t directory_offset = getUInt32( record.data() + 16 );
+
+    if ( entries_count == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF ) {
+        // ZIP64 archive: the actual values are in the ZIP64 end of central directory record
+        uint64_t locator_offset = archive_size - kEndOfCentralDirSize - kZip64LocatorSize;
+        if ( archive_size < kEndOfCentralDirSize + kZip64LocatorSize ) {
+            throw BitException( format_error );
+        }
+        record.resize( kZip64LocatorSize );
+        read_chunk( locator_offset, record );
+        if ( getUInt32( record.data() ) != kZip64LocatorSignature ) {
+            throw BitException( format_error );
+        }
+        uint64_t zip64_record_offset = getUInt64( record.data() + 8 );
+        if ( zip64_record_offset + kZip64EndOfCentralDirSize > locator_offset ) {
+            throw BitException( format_error );
+        }
+        record.resize( kZip64EndOfCentralDirSize );
+        read_chunk( zip64_record_offset, record );
+        if ( getUInt32( record.data() ) != kZip64EndOfCentralDirSignature ) {
+            throw BitException( format_error );
+        }
+        entries_count = getUInt64( record.data() + 32 );
+        directory_size = getUInt64( record.data() + 40 );
+        directory_offset = getUInt64( record.data() + 48 );
+    }
+    if ( directory_offset + directory_size > archive_size ) {
+        throw BitException( format_error );
+    }
+
+    // The local headers and the data of the entries are copied unchanged
+    vector< byte_t > block;
+    for ( uint64_t offset = 0; offset < directory_offset; offset += block.size() ) {
+        block.resize( static_cast< size_t >( std::min< uint64_t >( kCopyBlockSize, directory_offset - offset ) ) );
+        read_chunk( offset, block );
+        writeBuffer( mOutStream, block );
+    }
+
+    vector< byte_t > directory( static_cast< size_t >( directory_size ) );
+    if ( !directory.empty() ) {
+        read_chunk( directory_offset, directory );
+    }
+    size_t position = 0;
+    for ( uint64_t i = 0; i < entries_count; ++i ) {
+        if ( position + kCentralHeaderSize > directory.size() ||
+                getUInt32( &directory[ position ] ) != kCentralHeaderSignature ) {
+            throw BitException( format_error );
+        }
+        const byte_t* header = &directory[ position ];
+        size_t record_size = kCentralHeaderSize + getUInt16( header + 28 ) + getUInt16( header + 30 ) +
+                             getUInt16( header + 32 );
+        if ( position + record_size > directory.size() ) {
+            throw BitException( format_error );
+        }
+        appendEntry( header, record_size, mOffset );
+        position += record_size;
+    }
+    mOffset += directory_offset;
+    mEntriesCount += entries_count;
+}
+
+void ZipMerger::appendEntry( const byte_t* record, size_t record_size, uint64_t base_offset ) {
+    const uint16_t name_size = getUInt16( record + 28 );
+    const uint16_t extra_size = getUInt16( record + 30 );
+    const byte_t* extra = record + kCentralHeaderSize + name_size;
+    const byte_t* extra_end = extra + extra_size;
+
+    uint64_t unpack_size = getUInt32( record + 24 );
+    uint64_t pack_size = getUInt32( record + 20 );
+    uint64_t local_offset = getUInt32( record + 42 );
+    const bool zip64_unpack_size = unpack_size == 0xFFFFFFFF;
+    const bool zip64_pack_size = pack_size == 0xFFFFFFFF;
+    const bool zip64_offset = local_offset == 0xFFFFFFFF;
+
+    // Reading the ZIP64 extra field (if any), and keeping the other extra fields as they are
+    vector< byte_t > other_fields;
+    for ( const byte_t* field = extra; field + 4 <= extra_end; ) {
+        uint16_t field_id = getUInt16( field );
+        uint16_t field_size = getUInt16( field + 2 );
+        const byte_t* field_end = std::min( field + 4 + field_size, extra_end );
+        if ( field_id == kZip64ExtraId ) {
+            const byte_t* value = field + 4;
+            if ( zip64_unpack_size && value + 8 <= field_end ) {
+                unpack_size = getUInt64( value );
+                value += 8;
+            }
+            if ( zip64_pack_size && value + 8 <= field_end ) {
+                pack_size = getUInt64( value );
+                value += 8;
+            }
+            if ( zip64_offset && value + 8 <= field_end ) {
+                local_offset = getUInt64( value );
+            }
+        } else {
+            other_fields.insert( other_fields.end(), field, field_end );
+        }
+        field = field_end;
+    }
+    local_offset += base_offset;
+
+    // The original ZIP64 fields are kept, while new ones are added only if the values do not fit 32 bits anymore
+    vector< byte_t > zip64_field;
+    if ( zip64_unpack_size || unpack_size >= 0xFFFFFFFF ) {
+        appendUInt64( zip64_field, unpack_size );
+    }
+    if ( zip64_pack_size || pack_size >= 0xFFFFFFFF ) {
+        appendUInt64( zip64_field, pack_size );
+    }
+    if ( zip64_offset || local_offset >= 0xFFFFFFFF ) {
+        appendUInt64( zip64_field, local_offset );
+    }
+
+    vector< byte_t > header( record, record + kCentralHeaderSize );
+    if ( zip64_unpack_size || unpack_size >= 0xFFFFFFFF ) {
+        setUInt32( &header[ 24 ], 0xFFFFFFFF );
+    }
+    if ( zip64_pack_size || pack_size >= 0xFFFFFFFF ) {
+        setUInt32( &header[ 20 ], 0xFFFFFFFF );
+    }
+    setUInt32( &header[ 42 ], zip64_offset ? 0xFFFFFFFF : saturate32( local_offset ) );
+    if ( !zip64_field.empty() && getUInt16( &header[ 6 ] ) < kZip64Version ) {
+        setUInt16( &header[ 6 ], kZip64Version );
+    }
+    size_t new_extra_size = other_fields.size() + ( zip64_field.empty() ? 0 : 4 + zip64_field.size() );
+    setUInt16( &header[ 30 ], static_cast< uint16_t >( new_extra_size ) );
+
+    mCentralDirectory.insert( mCentralDirectory.end(), header.begin(), header.end() );
+    mCentralDirectory.insert( mCentralDirectory.end(), record + kCentralHeaderSize, extra ); // name
+    if ( !zip64_field.empty() ) {
+        appendUInt16( mCentralDirectory, kZip64ExtraId );
+        appendUInt16( mCentralDirectory, static_cast< uint16_t >( zip64_field.size() ) );
+        mCentralDirectory.insert( mCentralDirectory.end(), zip64_field.begin(), zip64_field.end() );
+    }
+    mCentralDirectory.insert( mCentralDirectory.end(), other_fields.begin(), other_fields.end() );
+    mCentralDirectory.insert( mCentralDirectory.end(), extra_end, record + record_size ); // comment
+}
+
+void ZipMerger::finalize() {
+    const uint64_t directory_offset = mOffset;
+    const uint64_t directory_size = mCentralDirectory.size();
+
+    vector< byte_t > trailer;
+    if ( mEntriesCount >= 0xFFFF || directory_offset >= 0xFFFFFFFF || directory_size >= 0xFFFFFFFF ) {
+        const uint64_t zip64_record_offset = directory_offset + directory_size;
+        appendUInt32( trailer, kZip64EndOfCentralDirSignature );
+        appendUInt64( trailer, kZip64EndOfCentralDirSize - 12 ); // size of the remaining record
+        appendUInt16( trailer, kZip64Version ); // version made by
+        appendUInt16( trailer, kZip64Version ); // version needed to extract
+        appendUInt32( trailer, 0 ); // number of this disk
+        appendUInt32( trailer, 0 ); // disk where the central directory starts
+        appendUInt64( trailer, mEntriesCount ); // entries on this disk
+        appendUInt64( trailer, mEntriesCount ); // total entries
+        appendUInt64( trailer, directory_size );
+        appendUInt64( trailer, directory_offset );
+
+        appendUInt32( trailer, kZip64LocatorSignature );
+        appendUInt32( trailer, 0 ); // disk where the ZIP64 end of central directory record is
+        appendUInt64( trailer, zip64_record_offset );
+        appendUInt32( trailer, 1 ); // total number of disks
+    }
+    appendUInt32( trailer, kEndOfCentralDirSignature );
+    appendUInt16( trailer, 0 ); // number of this disk
+    appendUInt16( trailer, 0 ); // disk where the central directory starts
+    appendUInt16( trailer, saturate16( mEntriesCount ) ); // entries on this disk
+    appendUInt16( trailer, saturate16( mEntriesCount ) ); // total entries
+    appendUInt32( trailer, saturate32( directory_size ) );
+    appendUInt32( trailer, saturate32( directory_offset ) );
+    appendUInt16( trailer, 0 ); // comment length
+
+    writeBuffer( mOutStream, mCentralDirectory );
+    writeBuffer( mOutStream, trailer );
+    mOffset += directory_size + trailer.size();
+}